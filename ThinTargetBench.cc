@@ -0,0 +1,452 @@
+// ThinTargetBench.cc
+// Throughput benchmark for the ThinTargetSim hot path.
+//
+// Measures, for every supported physics case, a set of representative
+// projectiles and a momentum ladder, the cost of
+// HadronicGenerator::GenerateInteraction (collisions/s, secondaries/s and
+// ns per secondary). computeObservables and, optionally, the analysis Fill
+// path are then timed on their own over a fixed sample of secondaries.
+// With -j, the analysis path is also run on that many pinned threads, first on
+// one NUMA node and then on all of them, each thread with its own analysis
+// instance and either its own copy of the sample or the one shared copy.
+// Results are written as JSON so that builds can be compared.
+#include "HadronicAnalysis.hh"
+#include "HadronicAnalysisLoader.hh"
+#include "HadronicGenerator.hh"
+#include "NumaPlacement.hh"
+#include "Observables.hh"
+
+#include <G4BaryonConstructor.hh>
+#include <G4BosonConstructor.hh>
+#include <G4HadronicParameters.hh>
+#include <G4IonConstructor.hh>
+#include <G4LeptonConstructor.hh>
+#include <G4Material.hh>
+#include <G4MesonConstructor.hh>
+#include <G4NistManager.hh>
+#include <G4NucleiProperties.hh>
+#include <G4ParticleTable.hh>
+#include <G4ShortLivedConstructor.hh>
+#include <G4SystemOfUnits.hh>
+#include <G4Version.hh>
+#include <Randomize.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct GeneratorResult {
+    std::string physics;
+    std::string projectile;
+    G4double momentumGeV = 0.;
+    G4int collisions = 0;
+    G4int emptyCollisions = 0;
+    long long secondaries = 0;
+    G4double seconds = 0.;
+};
+
+struct KernelResult {
+    std::string name;
+    long long calls = 0;
+    G4double seconds = 0.;
+};
+
+struct SecondarySample {
+    G4LorentzVector p4;
+    const G4ParticleDefinition* pd;
+};
+
+const std::vector<std::string> kAllPhysicsCases = {
+    "BERT", "BIC", "IonBIC", "INCL", "FTFP", "QGSP",
+    "FTFP_BERT_ATL", "FTFP_BERT", "QGSP_BERT", "QGSP_BIC", "FTFP_INCLXX"};
+
+const std::vector<std::string> kProjectiles = {
+    "proton", "neutron", "pi+", "pi-", "kaon+", "anti_proton", "deuteron", "alpha"};
+
+// Ladder chosen to straddle the BERT/FTFP, ATL and FTFP/QGSP transition regions.
+const std::vector<G4double> kMomentaGeV = {1.0, 4.5, 10.0, 20.0, 31.0, 158.0};
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+G4double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<G4double>(Clock::now() - start).count();
+}
+
+G4double safeRate(G4double n, G4double seconds) {
+    return seconds > 0. ? n / seconds : 0.;
+}
+
+void constructParticles() {
+    G4ParticleTable::GetParticleTable()->SetReadiness();
+    G4LeptonConstructor().ConstructParticle();
+    G4MesonConstructor().ConstructParticle();
+    G4BaryonConstructor().ConstructParticle();
+    G4IonConstructor().ConstructParticle();
+    G4BosonConstructor().ConstructParticle();
+    G4ShortLivedConstructor().ConstructParticle();
+}
+
+GeneratorResult benchmarkGenerator(HadronicGenerator& generator, const std::string& physics,
+                                   G4ParticleDefinition* projectile, G4double momentumGeV,
+                                   G4Material* material, G4int numCollisions, G4int numWarmup) {
+    GeneratorResult result;
+    result.physics = physics;
+    result.projectile = projectile->GetParticleName();
+    result.momentumGeV = momentumGeV;
+
+    const G4ThreeVector momentum(0., 0., momentumGeV * CLHEP::GeV);
+
+    for (G4int i = 0; i < numWarmup; ++i) {
+        auto aChange = generator.GenerateInteraction(projectile, momentum, material);
+        if (aChange) aChange->Clear();
+    }
+
+    const auto start = Clock::now();
+    for (G4int i = 0; i < numCollisions; ++i) {
+        auto aChange = generator.GenerateInteraction(projectile, momentum, material);
+        const G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
+        if (nsec == 0) ++result.emptyCollisions;
+        result.secondaries += nsec;
+        if (aChange) aChange->Clear();
+    }
+    result.seconds = secondsSince(start);
+    result.collisions = numCollisions;
+    return result;
+}
+
+// Aggregate throughput of the analysis path on `numThreads` threads pinned to
+// the first `numNodes` NUMA nodes. Every thread loads and initialises its own
+// analysis instance after pinning, so its reference binning and accumulators
+// are node-local; with `replicate` it also copies the sample, otherwise all
+// threads read the copy of the main thread.
+KernelResult benchmarkNuma(const std::string& analysisName, const std::vector<SecondarySample>& sample,
+                           const G4ThreeVector& boost, G4double sqrtS, G4int numCollisions,
+                           G4int numRepeats, std::size_t numThreads, std::size_t numNodes,
+                           G4bool replicate) {
+    NumaPlacement placement(NumaPlacement::kSpread, numNodes);
+    std::mutex setupMutex;
+    std::atomic<std::size_t> ready{0};
+    std::atomic<G4bool> go{false};
+    std::atomic<G4bool> failed{false};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            placement.Pin(t);
+            std::vector<SecondarySample> copy;
+            if (replicate) copy = sample;
+            const std::vector<SecondarySample>& secondaries = replicate ? copy : sample;
+            void* handle = nullptr;
+            HadronicAnalysis* analysis = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(setupMutex);
+                analysis = LoadAnalysisByName(analysisName, &handle);
+                if (analysis) analysis->Initialize(numCollisions * numRepeats);
+            }
+            if (!analysis) failed = true;
+            else {
+                const std::vector<AccumulatorBlock> blocks = analysis->Accumulators();
+                if (!blocks.empty()) placement.Record(t, "accumulators", blocks[0].data);
+                placement.Record(t, "sample", secondaries.data());
+            }
+            ++ready;
+            while (!go.load()) std::this_thread::yield();
+            if (!analysis) return;
+            const AcceptanceFilter acceptance(analysis->GetAcceptance());
+            for (G4int r = 0; r < numRepeats; ++r) {
+                for (const auto& s : secondaries) {
+                    if (!acceptance.Accepts(s.pd->GetPDGEncoding(), s.p4.vect())) continue;
+                    analysis->Fill(computeObservables(s.p4, s.pd, boost, sqrtS), s.pd);
+                }
+            }
+            std::lock_guard<std::mutex> lock(setupMutex);
+            UnloadAnalysis(analysis, handle);
+        });
+    }
+    while (ready.load() < numThreads) std::this_thread::yield();
+    const auto start = Clock::now();
+    go = true;
+    for (auto& thread : threads) thread.join();
+
+    KernelResult result;
+    std::ostringstream name;
+    name << analysisName << "::path x" << numThreads << " on " << placement.NumNodes() << " NUMA node(s), "
+         << (replicate ? "replicated" : "shared") << " sample";
+    result.name = name.str();
+    result.seconds = secondsSince(start);
+    result.calls = failed ? 0 : static_cast<long long>(sample.size()) * numRepeats * numThreads;
+    placement.PrintReport(std::cerr);
+    std::cerr << result.name << ": " << safeRate(result.calls, result.seconds) << " secondaries/s"
+              << std::endl;
+    return result;
+}
+
+void writeJson(std::ostream& os, const std::string& material, G4int numCollisions,
+               const std::vector<GeneratorResult>& generators,
+               const std::vector<KernelResult>& kernels) {
+    os << "{\n";
+    os << "  \"geant4_version\": " << G4VERSION_NUMBER << ",\n";
+    os << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+    os << "  \"timestamp\": " << static_cast<long long>(std::time(nullptr)) << ",\n";
+    os << "  \"material\": \"" << material << "\",\n";
+    os << "  \"collisions_per_point\": " << numCollisions << ",\n";
+
+    os << "  \"generate_interaction\": [";
+    for (std::size_t i = 0; i < generators.size(); ++i) {
+        const auto& r = generators[i];
+        os << (i ? ",\n" : "\n");
+        os << "    {\"physics\": \"" << r.physics << "\", \"projectile\": \"" << r.projectile
+           << "\", \"momentum_GeV\": " << r.momentumGeV << ", \"collisions\": " << r.collisions
+           << ", \"empty_collisions\": " << r.emptyCollisions
+           << ", \"secondaries\": " << r.secondaries << ", \"seconds\": " << r.seconds
+           << ", \"collisions_per_s\": " << safeRate(r.collisions, r.seconds)
+           << ", \"secondaries_per_s\": " << safeRate(r.secondaries, r.seconds)
+           << ", \"ns_per_secondary\": "
+           << (r.secondaries > 0 ? 1.e9 * r.seconds / r.secondaries : 0.) << "}";
+    }
+    os << "\n  ],\n";
+
+    os << "  \"kernels\": [";
+    for (std::size_t i = 0; i < kernels.size(); ++i) {
+        const auto& k = kernels[i];
+        os << (i ? ",\n" : "\n");
+        os << "    {\"name\": \"" << k.name << "\", \"calls\": " << k.calls
+           << ", \"seconds\": " << k.seconds
+           << ", \"ns_per_call\": " << (k.calls > 0 ? 1.e9 * k.seconds / k.calls : 0.) << "}";
+    }
+    os << "\n  ]\n";
+    os << "}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    G4int numCollisions = 2000;
+    G4int numWarmup = 20;
+    G4int numKernelRepeats = 20;
+    long seed = 12345;
+    std::string analysisName;
+    std::string outputFile;
+    std::string nameMaterial = "G4_C";
+    std::vector<std::string> physicsCases = kAllPhysicsCases;
+    std::size_t numThreads = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:c:j:m:n:o:r:s:w:")) != -1) {
+        if (opt == 'a') analysisName = optarg;
+        else if (opt == 'c') physicsCases = splitList(optarg);
+        else if (opt == 'j') numThreads = std::max(0, std::stoi(optarg));
+        else if (opt == 'm') nameMaterial = optarg;
+        else if (opt == 'n') numCollisions = std::stoi(optarg);
+        else if (opt == 'o') outputFile = optarg;
+        else if (opt == 'r') numKernelRepeats = std::stoi(optarg);
+        else if (opt == 's') seed = std::stol(optarg);
+        else if (opt == 'w') numWarmup = std::stoi(optarg);
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [-n Ncoll] [-w Nwarmup] [-c case1,case2,...] [-m material]"
+                         " [-a AnalysisName [-j threads]] [-r kernelRepeats] [-s seed] [-o out.json]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    G4Random::setTheSeed(seed);
+    constructParticles();
+    G4HadronicParameters::Instance()->SetEnableHyperNuclei(true);
+
+    G4Material* material = G4NistManager::Instance()->FindOrBuildMaterial(nameMaterial);
+    if (!material) {
+        std::cerr << "ERROR: Unknown material " << nameMaterial << std::endl;
+        return 1;
+    }
+
+    std::vector<GeneratorResult> generatorResults;
+    std::vector<SecondarySample> sample;
+    G4ThreeVector sampleBoost;
+    G4double sampleSqrtS = 0.;
+
+    for (const auto& physics : physicsCases) {
+        // The generators are deliberately never deleted: ~HadronicGenerator wipes the
+        // particle table, which every later physics case still needs.
+        auto* generator = new HadronicGenerator(physics);
+        if (!generator->IsPhysicsCaseSupported()) {
+            std::cerr << "Skipping unsupported physics case " << physics << std::endl;
+            continue;
+        }
+
+        for (const auto& nameProjectile : kProjectiles) {
+            G4ParticleDefinition* projectile =
+                G4ParticleTable::GetParticleTable()->FindParticle(nameProjectile);
+            if (!projectile) continue;
+
+            for (const G4double momentumGeV : kMomentaGeV) {
+                const G4double p = momentumGeV * CLHEP::GeV;
+                const G4double mass = projectile->GetPDGMass();
+                const G4double kineticEnergy = std::sqrt(p * p + mass * mass) - mass;
+                if (!generator->IsApplicable(projectile, kineticEnergy)) continue;
+
+                auto r = benchmarkGenerator(*generator, physics, projectile, momentumGeV,
+                                            material, numCollisions, numWarmup);
+                std::cerr << std::setw(14) << r.physics << std::setw(12) << r.projectile
+                          << std::setw(8) << r.momentumGeV << " GeV/c  "
+                          << safeRate(r.collisions, r.seconds) << " coll/s  "
+                          << safeRate(r.secondaries, r.seconds) << " sec/s" << std::endl;
+                generatorResults.push_back(r);
+            }
+        }
+
+        // Secondaries for the kernel benchmarks: the ThinTargetSim default beam.
+        if (sample.empty() && generator->IsApplicable("proton", 30.1 * CLHEP::GeV)) {
+            G4ParticleDefinition* proton = G4ParticleTable::GetParticleTable()->FindParticle("proton");
+            const G4ThreeVector momentum(0., 0., 31.0 * CLHEP::GeV);
+            const G4double mass = proton->GetPDGMass();
+            const G4Element* element = material->GetElement(0);
+            const G4int Z = static_cast<G4int>(element->GetZ());
+            const G4int A = (element->GetNumberOfIsotopes() > 0)
+                                ? element->GetIsotope(0)->GetN()
+                                : G4lrint(element->GetA() / (CLHEP::g / CLHEP::mole));
+            const G4LorentzVector labv(momentum, std::sqrt(momentum.mag2() + mass * mass)
+                                                     + G4NucleiProperties::GetNuclearMass(A, Z));
+            sampleBoost = labv.boostVector();
+            sampleSqrtS = labv.mag();
+
+            for (G4int i = 0; i < numCollisions; ++i) {
+                auto aChange = generator->GenerateInteraction(proton, momentum, material);
+                const G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
+                for (G4int j = 0; j < nsec; ++j) {
+                    const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+                    sample.push_back({sec->Get4Momentum(), sec->GetDefinition()});
+                }
+                if (aChange) aChange->Clear();
+            }
+        }
+    }
+
+    std::vector<KernelResult> kernelResults;
+    if (!sample.empty()) {
+        std::vector<Observables> observables;
+        observables.reserve(sample.size());
+        for (const auto& s : sample) {
+            observables.push_back(computeObservables(s.p4, s.pd, sampleBoost, sampleSqrtS));
+        }
+
+        KernelResult obsResult;
+        obsResult.name = "computeObservables";
+        G4double checksum = 0.;
+        auto start = Clock::now();
+        for (G4int r = 0; r < numKernelRepeats; ++r) {
+            for (const auto& s : sample) {
+                checksum += computeObservables(s.p4, s.pd, sampleBoost, sampleSqrtS).xF;
+            }
+        }
+        obsResult.seconds = secondsSince(start);
+        obsResult.calls = static_cast<long long>(sample.size()) * numKernelRepeats;
+        kernelResults.push_back(obsResult);
+        std::cerr << "computeObservables: "
+                  << 1.e9 * obsResult.seconds / obsResult.calls << " ns/call (checksum "
+                  << checksum << ")" << std::endl;
+
+        if (!analysisName.empty()) {
+            void* handle = nullptr;
+            HadronicAnalysis* analysis = LoadAnalysisByName(analysisName, &handle);
+            if (!analysis) return 2;
+            analysis->Initialize(numCollisions * numKernelRepeats);
+
+            KernelResult fillResult;
+            fillResult.name = analysisName + (handle ? "::Fill (plugin)" : "::Fill (static)");
+            start = Clock::now();
+            for (G4int r = 0; r < numKernelRepeats; ++r) {
+                for (std::size_t i = 0; i < sample.size(); ++i) {
+                    analysis->Fill(observables[i], sample[i].pd);
+                }
+            }
+            fillResult.seconds = secondsSince(start);
+            fillResult.calls = static_cast<long long>(sample.size()) * numKernelRepeats;
+            kernelResults.push_back(fillResult);
+            std::cerr << fillResult.name << ": " << 1.e9 * fillResult.seconds / fillResult.calls
+                      << " ns/call" << std::endl;
+
+            // Full per-secondary path of ThinTargetSim, with and without the
+            // acceptance pre-filter in front of computeObservables
+            const AcceptanceFilter acceptance(analysis->GetAcceptance());
+            if (!acceptance.AcceptsAll()) {
+                for (G4bool prefilter : {false, true}) {
+                    KernelResult pathResult;
+                    pathResult.name = analysisName + (prefilter ? "::path (pre-filtered)"
+                                                                : "::path (unfiltered)");
+                    long long accepted = 0;
+                    start = Clock::now();
+                    for (G4int r = 0; r < numKernelRepeats; ++r) {
+                        for (const auto& s : sample) {
+                            if (prefilter && !acceptance.Accepts(s.pd->GetPDGEncoding(), s.p4.vect())) {
+                                continue;
+                            }
+                            ++accepted;
+                            analysis->Fill(computeObservables(s.p4, s.pd, sampleBoost, sampleSqrtS), s.pd);
+                        }
+                    }
+                    pathResult.seconds = secondsSince(start);
+                    pathResult.calls = static_cast<long long>(sample.size()) * numKernelRepeats;
+                    kernelResults.push_back(pathResult);
+                    std::cerr << pathResult.name << ": "
+                              << 1.e9 * pathResult.seconds / pathResult.calls << " ns/secondary ("
+                              << 100. * accepted / pathResult.calls << "% accepted)" << std::endl;
+                }
+            }
+
+            // Finalize is skipped on purpose: it would overwrite the reference
+            // file in the working directory with benchmark histograms.
+            UnloadAnalysis(analysis, handle);
+
+            // One socket, then all of them
+            if (numThreads > 0) {
+                const std::size_t allNodes = NumaPlacement(NumaPlacement::kSpread).NumNodes();
+                for (const std::size_t numNodes : {std::size_t(1), allNodes}) {
+                    for (const G4bool replicate : {true, false}) {
+                        kernelResults.push_back(benchmarkNuma(analysisName, sample, sampleBoost, sampleSqrtS,
+                                                              numCollisions, numKernelRepeats, numThreads,
+                                                              numNodes, replicate));
+                    }
+                    if (allNodes <= 1) break;
+                }
+            }
+        }
+    }
+
+    if (outputFile.empty()) {
+        writeJson(std::cout, nameMaterial, numCollisions, generatorResults, kernelResults);
+    }
+    else {
+        std::ofstream out(outputFile);
+        if (!out) {
+            std::cerr << "ERROR: Cannot open " << outputFile << std::endl;
+            return 1;
+        }
+        writeJson(out, nameMaterial, numCollisions, generatorResults, kernelResults);
+        std::cerr << "Benchmark results written to " << outputFile << std::endl;
+    }
+    return 0;
+}
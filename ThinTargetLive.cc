@@ -0,0 +1,157 @@
+// ThinTargetLive.cc
+// Writes the current results of a running ThinTargetSim as YODA.
+//
+// ThinTargetSim --live <name> publishes its analysis accumulators into the
+// shared-memory segment <name> (one segment <name>.<worker> per worker with
+// --fork). This tool takes a consistent copy of each segment without stopping
+// the run, loads and initialises the same analysis as the run did, sets its
+// accumulators to the sum of the copies and calls Finalize, which writes the
+// usual outputs tagged "live" (e.g. NA61_2009_I151002703_live.yoda),
+// normalised to the collisions run so far. Run it in the working directory of
+// the run, so that the analysis finds the same reference files.
+#include "HadronicAnalysis.hh"
+#include "HadronicAnalysisLoader.hh"
+#include "LiveSnapshot.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "YODA/WriterYODA.h"
+
+namespace {
+
+G4bool segmentExists(const std::string& name)
+{
+    if (name.empty()) return false;
+    const int fd = shm_open((name[0] == '/' ? name : "/" + name).c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+
+// The segments given, a name without a segment of its own standing for the
+// worker segments name.0, name.1, ... of a --fork run
+std::vector<std::string> expandSegments(const std::vector<std::string>& names)
+{
+    std::vector<std::string> segments;
+    for (const auto& name : names) {
+        if (segmentExists(name) || !segmentExists(name + ".0")) {
+            segments.push_back(name);
+            continue;
+        }
+        for (G4int w = 0; segmentExists(name + "." + std::to_string(w)); ++w) {
+            segments.push_back(name + "." + std::to_string(w));
+        }
+    }
+    return segments;
+}
+
+// Sum the snapshots of `segments` and finalize them; false on any mismatch
+G4bool dump(const std::vector<std::string>& segments, const std::string& tag)
+{
+    LiveSnapshotHeader header;
+    std::vector<std::uint64_t> blockSizes;
+    std::vector<G4double> values;
+    std::string analysisName;
+    std::string outputTag;
+    RunInfo run;
+    std::int64_t collisions = 0;
+    std::int64_t totalCollisions = 0;
+    std::vector<std::uint64_t> sumSizes;
+    std::vector<G4double> sum;
+    for (const auto& segment : segments) {
+        if (!LiveSnapshot::Read(segment, header, blockSizes, values)) return false;
+        const std::string name(header.analysis, strnlen(header.analysis, sizeof(header.analysis)));
+        if (sum.empty()) {
+            analysisName = name;
+            outputTag.assign(header.outputTag, strnlen(header.outputTag, sizeof(header.outputTag)));
+            run.inelasticXS = header.inelasticXS;
+            run.bootstrapReplicas = header.bootstrapReplicas;
+            sumSizes = blockSizes;
+            sum.assign(values.size(), 0.);
+        }
+        if (name != analysisName || blockSizes != sumSizes) {
+            std::cerr << "ERROR: " << segment << " is not a snapshot of the same run as " << segments[0]
+                      << std::endl;
+            return false;
+        }
+        for (std::size_t k = 0; k < values.size(); ++k) sum[k] += values[k];
+        collisions += header.collisions;
+        totalCollisions += header.totalCollisions;
+    }
+
+    void* handle = nullptr;
+    HadronicAnalysis* analysis = LoadAnalysisByName(analysisName, &handle);
+    if (!analysis) return false;
+    run.numCollisions = static_cast<G4int>(collisions);
+    run.outputTag = outputTag.empty() ? tag : outputTag + "_" + tag;
+    analysis->SetRunInfo(run);
+    analysis->Initialize(run.numCollisions);
+
+    const std::vector<AccumulatorBlock> blocks = analysis->Accumulators();
+    G4bool ok = blocks.size() == sumSizes.size();
+    for (std::size_t b = 0; ok && b < blocks.size(); ++b) ok = blocks[b].size == sumSizes[b];
+    if (ok) {
+        const G4double* from = sum.data();
+        for (const auto& block : blocks) {
+            std::copy(from, from + block.size, block.data);
+            from += block.size;
+        }
+        std::cout << analysisName << ": " << collisions << " of " << totalCollisions << " collisions from "
+                  << segments.size() << " snapshot(s)" << std::endl;
+        analysis->Finalize();
+    }
+    else {
+        std::cerr << "ERROR: " << analysisName << " is booked differently here than in the run"
+                  << std::endl;
+    }
+    UnloadAnalysis(analysis, handle);
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string tag = "live";
+    G4double repeatSeconds = 0.;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:")) != -1) {
+        if (opt == 't') tag = optarg;
+        else if (opt == 'w') repeatSeconds = std::stod(optarg);
+        else {
+            optind = argc;
+            break;
+        }
+    }
+    if (optind >= argc) {
+        std::cerr << "Usage: " << argv[0] << " [-t tag] [-w seconds] <name> [<name>...]" << std::endl
+                  << "  Writes the current results of ThinTargetSim --live <name> runs." << std::endl
+                  << "  A <name> of a --fork run stands for all its worker segments." << std::endl
+                  << "  -t  output tag (default live)" << std::endl
+                  << "  -w  repeat every <seconds> until the run has ended" << std::endl;
+        return 1;
+    }
+    const std::vector<std::string> names(argv + optind, argv + argc);
+
+    for (G4bool first = true;; first = false) {
+        // With -w, the segments disappearing means that the run has ended
+        if (!dump(expandSegments(names), tag)) return first ? 1 : 0;
+        if (repeatSeconds <= 0.) return 0;
+        std::this_thread::sleep_for(std::chrono::duration<G4double>(repeatSeconds));
+    }
+}
+
+#ifdef WITH_YODA
+// Force the linker to keep libYODA.so by actually using a symbol
+static auto __force_yoda_link = YODA::WriterYODA::create();
+#endif
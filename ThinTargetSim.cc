@@ -1,16 +1,38 @@
 // main.cc (refactored from your original main)
+#include "AllocationTracker.hh"
+#include "AnalysisPipeline.hh"
+#include "BeamModel.hh"
+#include "BootstrapReplicas.hh"
+#include "Chi2Monitor.hh"
+#include "ChunkScheduler.hh"
+#include "CrossSectionTable.hh"
+#include "EventJournal.hh"
+#include "ForkPool.hh"
 #include "HadronicAnalysis.hh"
 #include "Observables.hh"
 #include "HadronicAnalysisLoader.hh"
 #include "HadronicGenerator.hh"
+#include "HepMCWriter.hh"
+#include "LiveSnapshot.hh"
+#include "ModelTimingProfiler.hh"
+#include "NumaPlacement.hh"
+#include "ParameterVariations.hh"
+#include "ProgressMonitor.hh"
+#include "ResultCache.hh"
+#include "RunMatrix.hh"
+#include "TargetModel.hh"
+#include "G4HadronicInteraction.hh"
 #include "G4HadronicParameters.hh"
+#include "G4NucleiProperties.hh"
+#include "G4Threading.hh"
+#include "G4Version.hh"
+#include "G4WorkerThread.hh"
+#include "Randomize.hh"
 
 #include <G4ParticleTable.hh>
 #include <G4SystemOfUnits.hh>
 #include <G4NistManager.hh>
-#include <G4Element.hh>
 #include <G4Material.hh>
-#include <G4NucleiProperties.hh>
 #include <G4LeptonConstructor.hh>
 #include <G4MesonConstructor.hh>
 #include <G4BaryonConstructor.hh>
@@ -18,97 +40,1190 @@
 #include <G4BosonConstructor.hh>
 #include <G4ShortLivedConstructor.hh>
 #include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "YODA/WriterYODA.h"
 
-#include <dlfcn.h>
+static void constructParticles() {
+    G4ParticleTable::GetParticleTable()->SetReadiness();
+    G4LeptonConstructor().ConstructParticle();
+    G4MesonConstructor().ConstructParticle();
+    G4BaryonConstructor().ConstructParticle();
+    G4IonConstructor().ConstructParticle();
+    G4BosonConstructor().ConstructParticle();
+    G4ShortLivedConstructor().ConstructParticle();
+
+    G4HadronicParameters::Instance()->SetEnableHyperNuclei(true);
+}
+
+// Regenerate collision `event` of a journaled run on its own
+static int replayEvent(const std::string& journalFile, G4int event, G4bool dump) {
+    EventJournal journal;
+    if (!journal.Open(journalFile)) return 1;
+    const JournalHeader& header = journal.Header();
+    if (event < 0 || event >= journal.NumRecords()) {
+        std::cerr << "ERROR: Journal " << journalFile << " has " << journal.NumRecords()
+                  << " collisions" << std::endl;
+        return 1;
+    }
+    const JournalRecord& record = journal.Record(event);
+    if (record.seed == 0 && record.pz == 0.) {
+        std::cerr << "ERROR: Collision " << event << " was never started" << std::endl;
+        return 1;
+    }
+    if (header.g4Version != G4VERSION_NUMBER) {
+        std::cerr << "WARNING: Journal written with Geant4 " << header.g4Version << ", replaying with "
+                  << G4VERSION_NUMBER << ": the collision will differ" << std::endl;
+    }
+
+    constructParticles();
+    G4ParticleDefinition* projectile = G4ParticleTable::GetParticleTable()->FindParticle(header.projectile);
+    G4Material* material = G4NistManager::Instance()->FindOrBuildMaterial(header.material);
+    if (!projectile || !material) return 1;
+    HadronicGenerator* theHadronicGenerator = new HadronicGenerator(header.physics);
+    if (!theHadronicGenerator->IsPhysicsCaseSupported()) return 3;
+
+    const G4ThreeVector momentum(record.px, record.py, record.pz);
+    TargetModel target(material, header.thickness);
+    target.Prepare(*theHadronicGenerator, projectile, momentum);
+
+    G4Random::setTheSeed(record.seed);
+    const auto start = std::chrono::steady_clock::now();
+    auto aChange = theHadronicGenerator->GenerateInteraction(projectile, momentum, material);
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    const G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
+
+    std::cout << "Collision " << event << " of " << header.projectile << " on " << header.material
+              << " (" << header.physics << "), seed " << record.seed << ", beam "
+              << momentum / CLHEP::GeV << " GeV/c" << std::endl;
+    std::cout << "  journal: " << record.numSecondaries << " secondaries, nucleus " << record.nucleus
+              << ", " << 1.e-6 * record.nanoseconds << " ms" << std::endl;
+    if (record.numSecondaries < 0) std::cout << "  (the journaled run did not complete it)" << std::endl;
+    if (nsec == 0) {
+        std::cout << "  replay:  no secondaries, " << 1.e-6 * ns << " ms" << std::endl;
+        return 0;
+    }
+
+    const TargetModel::Nucleus& struck = target.StruckNucleus(theHadronicGenerator->GetHadronicProcess());
+    const G4int nucleus = 1000 * struck.Z + struck.A;
+    std::cout << "  replay:  " << nsec << " secondaries, nucleus " << nucleus << ", " << 1.e-6 * ns
+              << " ms, model " << theHadronicGenerator->GetHadronicInteraction()->GetModelName()
+              << std::endl;
+    if (record.numSecondaries >= 0 && (nsec != record.numSecondaries || nucleus != record.nucleus)) {
+        std::cout << "  WARNING: replay differs from the journal" << std::endl;
+    }
+
+    if (dump) {
+        const G4double mass = projectile->GetPDGMass();
+        const G4LorentzVector labv(momentum, std::sqrt(momentum.mag2() + mass * mass) + struck.mass);
+        std::cout << std::setw(5) << "#" << std::setw(14) << "particle" << std::setw(12) << "pdg"
+                  << std::setw(12) << "p[GeV]" << std::setw(14) << "theta[mrad]" << std::setw(12)
+                  << "T[GeV]" << std::setw(10) << "xF" << std::setw(10) << "y_cms" << std::endl;
+        for (G4int j = 0; j < nsec; ++j) {
+            const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+            const auto* pd = sec->GetDefinition();
+            const Observables obs = computeObservables(sec->Get4Momentum(), pd, labv.boostVector(), labv.mag());
+            std::cout << std::setw(5) << j << std::setw(14) << pd->GetParticleName() << std::setw(12)
+                      << pd->GetPDGEncoding() << std::setw(12) << obs.p_lab.mag() / CLHEP::GeV
+                      << std::setw(14) << obs.theta_lab / CLHEP::milliradian << std::setw(12)
+                      << obs.T_lab / CLHEP::GeV << std::setw(10) << obs.xF << std::setw(10) << obs.y_cms
+                      << std::endl;
+        }
+    }
+    aChange->Clear();
+    return 0;
+}
+
+// Additive state of a run: the analysis accumulators, then (Z, A, struck) of
+// every nucleus sampled. Forked workers send it; the result cache stores it.
+static std::vector<std::vector<G4double>> runState(HadronicAnalysis& analysis, const TargetModel& target) {
+    std::vector<std::vector<G4double>> state;
+    for (const auto& block : analysis.Accumulators()) {
+        state.emplace_back(block.data, block.data + block.size);
+    }
+    std::vector<G4double> struck;
+    for (const auto& n : target.GetNuclei()) {
+        struck.insert(struck.end(), {G4double(n.Z), G4double(n.A), G4double(n.struck)});
+    }
+    state.push_back(std::move(struck));
+    return state;
+}
+
+// The runState() layout of `analysis`
+static G4bool matchesRunState(const std::vector<std::vector<G4double>>& state, HadronicAnalysis& analysis) {
+    const std::vector<AccumulatorBlock> blocks = analysis.Accumulators();
+    if (state.size() != blocks.size() + 1) return false;
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        if (state[b].size() != blocks[b].size) return false;
+    }
+    return true;
+}
+
+// Add a runState() of the same configuration; false, and nothing added, if it does not match
+static G4bool addRunState(const std::vector<std::vector<G4double>>& state, HadronicAnalysis& analysis,
+                          TargetModel& target) {
+    if (!matchesRunState(state, analysis)) return false;
+    const std::vector<AccumulatorBlock> blocks = analysis.Accumulators();
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        for (std::size_t k = 0; k < blocks[b].size; ++k) blocks[b].data[k] += state[b][k];
+    }
+    const std::vector<G4double>& struck = state.back();
+    for (std::size_t k = 0; k + 2 < struck.size(); k += 3) {
+        target.AddStruck(G4int(struck[k]), G4int(struck[k + 1]), static_cast<std::uint64_t>(struck[k + 2]));
+    }
+    return true;
+}
+
+// Run every configuration of a run matrix on `numThreads` workers, chunk by
+// chunk (see ChunkScheduler). Each worker keeps one generator per physics case
+// and one analysis instance per configuration; the instances of a
+// configuration are merged through their accumulators before Finalize.
+// Collision i of every configuration uses the same seed as collision i of a
+// single run with this run seed. Workers build all of their state on their
+// own thread, after `placement`, if given, has pinned them to a NUMA node.
+static int runMatrix(const std::string& matrixFile, const std::string& analysisName,
+                     std::size_t numThreads, long runSeed, G4int bootstrapReplicas,
+                     G4double progressInterval, const std::string& statusFile,
+                     const std::string& xsCacheFile, NumaPlacement* placement) {
+    const std::vector<RunConfiguration> configs = ReadRunMatrix(matrixFile);
+    if (configs.empty()) return 1;
+#ifndef G4MULTITHREADED
+    if (numThreads > 1) {
+        std::cerr << "WARNING: Geant4 was built without multithreading, running on one worker"
+                  << std::endl;
+        numThreads = 1;
+    }
+#endif
+    numThreads = std::max<std::size_t>(numThreads, 1);
+
+    // Shared state is set up here, before any worker starts: materials are
+    // built on demand by the NIST manager, and the first generator of each
+    // physics case fills the cross-section tables the workers' copies share
+    constructParticles();
+    std::vector<G4ParticleDefinition*> projectiles;
+    std::vector<G4Material*> materials;
+    std::vector<TargetModel> targets;
+    std::map<std::string, HadronicGenerator*> masterGenerators;
+    std::map<std::string, std::unique_ptr<CrossSectionTable>> crossSections;
+    std::map<std::string, std::vector<std::pair<G4ParticleDefinition*, G4Material*>>> xsPairs;
+    std::vector<std::int64_t> collisionsPerConfig;
+    for (const auto& c : configs) {
+        G4ParticleDefinition* projectile = G4ParticleTable::GetParticleTable()->FindParticle(c.projectile);
+        G4Material* material = G4NistManager::Instance()->FindOrBuildMaterial(c.material);
+        if (!projectile || !material) {
+            std::cerr << "ERROR: Unknown projectile or material in configuration " << c.tag << std::endl;
+            return 1;
+        }
+        HadronicGenerator*& generator = masterGenerators[c.physics];
+        if (!generator) {
+            generator = new HadronicGenerator(c.physics);
+            if (!generator->IsPhysicsCaseSupported()) return 3;
+            // One cache per physics case: an explicit file name gets the case appended
+            crossSections[c.physics] = std::make_unique<CrossSectionTable>(
+                c.physics, xsCacheFile.empty() ? "" : xsCacheFile + "." + c.physics);
+        }
+        xsPairs[c.physics].emplace_back(projectile, material);
+        const G4double mass = projectile->GetPDGMass();
+        if (!generator->IsApplicable(projectile, std::sqrt(c.momentum * c.momentum + mass * mass) - mass)) {
+            std::cerr << "WARNING: " << c.physics << " does not handle configuration " << c.tag
+                      << ", it will have no secondaries" << std::endl;
+        }
+        projectiles.push_back(projectile);
+        materials.push_back(material);
+        targets.emplace_back(material, c.thickness);
+        targets.back().Prepare(*generator, projectile, G4ThreeVector(0., 0., c.momentum));
+        collisionsPerConfig.push_back(c.numCollisions);
+    }
+    for (const auto& [physics, pairs] : xsPairs) {
+        crossSections[physics]->Require(*masterGenerators[physics], pairs);
+    }
+
+    std::vector<RunInfo> runInfos(configs.size());
+    for (std::size_t c = 0; c < configs.size(); ++c) {
+        RunInfo& runInfo = runInfos[c];
+        runInfo.numCollisions = static_cast<G4int>(configs[c].numCollisions);
+        runInfo.inelasticXS =
+            crossSections[configs[c].physics]->Inelastic(projectiles[c], materials[c], configs[c].momentum);
+        runInfo.bootstrapReplicas = bootstrapReplicas;
+        runInfo.outputTag = configs[c].tag;
+    }
+    {
+        // The workers load their own instances; check here that they can be merged
+        void* handle = nullptr;
+        HadronicAnalysis* probe = LoadAnalysisByName(analysisName, &handle);
+        if (!probe) return 2;
+        probe->SetRunInfo(runInfos[0]);
+        probe->Initialize(runInfos[0].numCollisions);
+        const G4bool mergeable = !probe->Accumulators().empty();
+        UnloadAnalysis(probe, handle);
+        if (numThreads > 1 && !mergeable) {
+            std::cerr << "ERROR: " << analysisName << " has no accumulators to merge,"
+                      << " run the matrix with -j 1" << std::endl;
+            return 2;
+        }
+    }
+
+    // Everything a worker touches per collision, including one analysis
+    // instance per configuration, allocated by initWorker on the worker's thread
+    struct WorkerState {
+        std::map<std::string, HadronicGenerator*> generators;
+        std::vector<TargetModel> targets;
+        BootstrapWeights bootstrapWeights;
+        std::vector<HadronicAnalysis*> analyses;
+        std::vector<void*> handles;
+        std::vector<AcceptanceFilter> acceptances;
+    };
+    const std::uint64_t bootstrapSeed = static_cast<std::uint64_t>(runSeed) ^ 0xB0075EEDULL;
+    std::vector<WorkerState> workers;
+    for (std::size_t w = 0; w < numThreads; ++w) {
+        workers.push_back({{}, {}, BootstrapWeights(bootstrapReplicas, bootstrapSeed), {}, {}, {}});
+    }
+    std::atomic<G4bool> setupFailed{false};
+
+    std::unique_ptr<ProgressMonitor> progress;
+    if (progressInterval > 0.) {
+        std::uint64_t total = 0;
+        for (const auto n : collisionsPerConfig) total += n;
+        progress = std::make_unique<ProgressMonitor>(total, progressInterval, statusFile, numThreads);
+    }
+
+    std::mutex setupMutex;
+    auto initWorker = [&](std::size_t w) {
+        if (placement) placement->Pin(w);
+        WorkerState& state = workers[w];
+#ifdef G4MULTITHREADED
+        // Thread-local Geant4 state, as a worker run manager would set it up
+        G4Threading::G4SetThreadId(static_cast<G4int>(w));
+        G4WorkerThread::BuildGeometryAndPhysicsVector();
+        G4ParticleTable::GetParticleTable()->WorkerG4ParticleTable();
+#endif
+        // Generators register processes and models in Geant4 singletons while
+        // they are built, and analyses load plugins and reference files: one
+        // worker at a time. Generators are never deleted (see
+        // HadronicGenerator::~HadronicGenerator).
+        std::lock_guard<std::mutex> lock(setupMutex);
+#ifdef G4MULTITHREADED
+        for (const auto& entry : masterGenerators) {
+            state.generators[entry.first] = new HadronicGenerator(entry.first);
+        }
+#else
+        state.generators = masterGenerators;
+#endif
+        state.targets = targets;
+        state.bootstrapWeights = BootstrapWeights(bootstrapReplicas, bootstrapSeed);
+        for (std::size_t c = 0; c < configs.size(); ++c) {
+            void* handle = nullptr;
+            HadronicAnalysis* analysis = LoadAnalysisByName(analysisName, &handle);
+            if (!analysis) {
+                setupFailed = true;
+                return;
+            }
+            analysis->SetRunInfo(runInfos[c]);
+            analysis->Initialize(runInfos[c].numCollisions);
+            state.analyses.push_back(analysis);
+            state.handles.push_back(handle);
+            state.acceptances.emplace_back(analysis->GetAcceptance());
+        }
+        if (placement) {
+            const std::vector<AccumulatorBlock> blocks = state.analyses[0]->Accumulators();
+            if (!blocks.empty()) placement->Record(w, "accumulators", blocks[0].data);
+            placement->Record(w, "target tables", state.targets.data());
+            // Only the generators of multithreaded builds are the worker's own
+            placement->Record(w, "generator", state.generators.begin()->second);
+        }
+    };
+
+    auto runChunk = [&](std::size_t w, const ChunkScheduler::Chunk& chunk) {
+        const RunConfiguration& config = configs[chunk.config];
+        WorkerState& state = workers[w];
+        // A worker whose setup failed runs nothing; the run is reported as failed
+        if (state.analyses.size() != configs.size()) return;
+        HadronicGenerator* generator = state.generators[config.physics];
+        HadronicAnalysis* analysis = state.analyses[chunk.config];
+        const AcceptanceFilter& acceptance = state.acceptances[chunk.config];
+        TargetModel& target = state.targets[chunk.config];
+        G4ParticleDefinition* projectile = projectiles[chunk.config];
+        G4Material* material = materials[chunk.config];
+        const G4ThreeVector momentum(0., 0., config.momentum);
+        const G4double beamEnergy = std::sqrt(momentum.mag2() + std::pow(projectile->GetPDGMass(), 2));
+
+        EventInfo eventInfo;
+        for (std::int64_t i = chunk.first; i < chunk.first + chunk.count; ++i) {
+            eventInfo.index = static_cast<G4int>(i);
+            if (bootstrapReplicas > 0) {
+                state.bootstrapWeights.Draw(i);
+                eventInfo.bootstrapWeights = state.bootstrapWeights.Get();
+            }
+            G4Random::setTheSeed(EventJournal::EventSeed(runSeed, i));
+            AllocationTracker::SetPhase(AllocationTracker::kGeneration);
+            auto aChange = generator->GenerateInteraction(projectile, momentum, material);
+            const G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
+            eventInfo.generator = &generator->GetEventRecord();
+            analysis->BeginEvent(eventInfo);
+            G4ThreeVector cmsBoost;
+            G4double sqrtS = 0.;
+            if (nsec > 0) {
+                const TargetModel::Nucleus& struck = target.StruckNucleus(generator->GetHadronicProcess());
+                cmsBoost = G4LorentzVector(momentum, beamEnergy + struck.mass).boostVector();
+                sqrtS = struck.sqrtS;
+            }
+            for (G4int j = 0; j < nsec; ++j) {
+                const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+                const auto* pd = sec->GetDefinition();
+                if (!acceptance.Accepts(pd->GetPDGEncoding(), sec->GetMomentum())) continue;
+                AllocationTracker::SetPhase(AllocationTracker::kObservables);
+                const Observables obs = computeObservables(sec->Get4Momentum(), pd, cmsBoost, sqrtS);
+                AllocationTracker::SetPhase(AllocationTracker::kFill);
+                analysis->Fill(obs, pd);
+            }
+            AllocationTracker::SetPhase(AllocationTracker::kGeneration);
+            if (aChange) aChange->Clear();
+            if (progress) progress->Add(nsec, w);
+        }
+        AllocationTracker::SetPhase(AllocationTracker::kOther);
+    };
+
+    ChunkScheduler scheduler(collisionsPerConfig, numThreads);
+    scheduler.Run(initWorker, runChunk, [&progress] {
+        if (progress) progress->ReportIfDue();
+    });
+    if (progress) progress->Finish();
+    scheduler.PrintStatistics(std::cout);
+    if (placement) placement->PrintReport(std::cout);
+    if (AllocationTracker::kEnabled) {
+        std::uint64_t totalCollisions = 0;
+        for (const std::int64_t n : collisionsPerConfig) totalCollisions += n;
+        AllocationReport::PrintRun(std::cout, totalCollisions);
+    }
+    if (setupFailed) {
+        std::cerr << "ERROR: " << analysisName << " could not be loaded on every worker" << std::endl;
+        return 2;
+    }
+
+    for (std::size_t c = 0; c < configs.size(); ++c) {
+        for (std::size_t w = 1; w < numThreads; ++w) {
+            mergeAccumulators(*workers[0].analyses[c], *workers[w].analyses[c]);
+            workers[0].targets[c].Merge(workers[w].targets[c]);
+        }
+        std::cout << "==== Configuration " << c << ": " << configs[c].tag << " ====" << std::endl;
+        workers[0].analyses[c]->Finalize();
+        workers[0].targets[c].Print(std::cout);
+        for (auto& worker : workers) UnloadAnalysis(worker.analyses[c], worker.handles[c]);
+    }
+    return 0;
+}
+
+// Run every parameter variation of `variationsFile` on the same collisions.
+// Each variation gets its own generator, built while its parameters are set,
+// and its own analysis instance, whose outputs are tagged with the variation;
+// particles, the material, the cross sections and the beam are shared.
+// Collision i of every variation starts from the seed of collision i of a
+// single run, so that differences between variations are not buried under
+// independent fluctuations. With chi2Abort > 0 a variation that cannot end
+// up below it is dropped, without outputs, while the others go on.
+static int runVariations(const std::string& variationsFile, const std::string& analysisName,
+                         G4int numCollisions, long runSeed, G4int bootstrapReplicas,
+                         G4double progressInterval, const std::string& statusFile,
+                         const std::string& xsCacheFile, const G4String& namePhysics,
+                         G4ParticleDefinition* projectile, G4Material* material, G4double thickness,
+                         BeamModel& beam, G4double chi2Abort, G4int chi2Every) {
+    const std::vector<ParameterVariation> variations = ReadParameterVariations(variationsFile);
+    if (variations.empty()) return 1;
+    const G4ThreeVector nominalMomentum(0., 0., beam.GetNominalMomentum());
+
+    // FTF builds its parameters, and defines the developer parameters, at the
+    // first collision it handles, which need not be the first collision of a
+    // generator: run the beam until FTF has handled one, or give up
+    constexpr G4int kMaxWarmUpCollisions = 1000;
+    auto warmUp = [&](HadronicGenerator* generator) {
+        for (G4int k = 0; k < kMaxWarmUpCollisions; ++k) {
+            G4Random::setTheSeed(EventJournal::EventSeed(runSeed, -1 - k));
+            auto aChange = generator->GenerateInteraction(projectile, nominalMomentum, material);
+            if (aChange) aChange->Clear();
+            if (generator->GetEventRecord().handledByFTF) return true;
+        }
+        return false;
+    };
+    auto reportNoFTF = [&](const std::string& tag) {
+        std::cerr << "ERROR: FTF handled none of " << kMaxWarmUpCollisions << " warm-up collisions of "
+                  << tag << " with physics " << namePhysics << ", so its FTF parameters would never"
+                  << " be read; choose a physics case using FTF at this beam (--physics)" << std::endl;
+    };
+    const G4bool needsFTF = std::any_of(variations.begin(), variations.end(), SetsDeveloperParameters);
+
+    HadronicGenerator* nominal = new HadronicGenerator(namePhysics);
+    if (!nominal->IsPhysicsCaseSupported()) return 3;
+    if (!warmUp(nominal) && needsFTF) {
+        reportNoFTF("the nominal generator");
+        return 3;
+    }
+    TargetModel nominalTarget(material, thickness);
+    nominalTarget.Prepare(*nominal, projectile, nominalMomentum);
+    beam.SetTarget(nominalTarget);
+    CrossSectionTable crossSections(namePhysics, xsCacheFile);
+    crossSections.Require(*nominal, {{projectile, material}});
+
+    RunInfo runInfo;
+    runInfo.numCollisions = numCollisions;
+    runInfo.inelasticXS = crossSections.Inelastic(projectile, material, beam.GetNominalMomentum());
+    runInfo.bootstrapReplicas = bootstrapReplicas;
+
+    std::vector<HadronicGenerator*> generators;
+    std::vector<HadronicAnalysis*> analyses;
+    std::vector<void*> handles;
+    std::vector<AcceptanceFilter> acceptances;
+    std::vector<TargetModel> targets;
+    std::vector<std::unique_ptr<Chi2Monitor>> monitors;
+    for (const auto& variation : variations) {
+        HadronicGenerator* generator = nominal;
+        if (!variation.parameters.empty()) {
+            // Lazily built model state reads the parameters too: build it while they are set
+            ParameterOverride parameters(variation);
+            if (!parameters.IsValid()) return 1;
+            generator = new HadronicGenerator(namePhysics);
+            if (!warmUp(generator) && SetsDeveloperParameters(variation)) {
+                reportNoFTF("variation " + variation.tag);
+                return 3;
+            }
+        }
+        generators.push_back(generator);
+
+        void* handle = nullptr;
+        HadronicAnalysis* analysis = LoadAnalysisByName(analysisName, &handle);
+        if (!analysis) return 2;
+        runInfo.outputTag = variation.tag;
+        analysis->SetRunInfo(runInfo);
+        analysis->Initialize(numCollisions);
+        analyses.push_back(analysis);
+        handles.push_back(handle);
+        acceptances.emplace_back(analysis->GetAcceptance());
+        targets.push_back(nominalTarget);
+        if (chi2Abort > 0.) {
+            monitors.push_back(std::make_unique<Chi2Monitor>(
+                chi2Abort, chi2Every > 0 ? chi2Every : (numCollisions + 19) / 20, numCollisions));
+            if (!monitors.back()->IsEnabled(*analysis)) {
+                std::cerr << "ERROR: " << analysis->GetName() << " has no reference points to compare"
+                          << " to, --chi2-abort cannot be used" << std::endl;
+                return 2;
+            }
+        }
+    }
+    std::cout << "Running " << variations.size() << " parameter variations of " << namePhysics
+              << std::endl;
+
+    std::unique_ptr<ProgressMonitor> progress;
+    if (progressInterval > 0.) {
+        progress = std::make_unique<ProgressMonitor>(std::uint64_t(numCollisions) * variations.size(),
+                                                     progressInterval, statusFile);
+    }
+
+    BootstrapWeights bootstrapWeights(bootstrapReplicas, static_cast<std::uint64_t>(runSeed) ^ 0xB0075EEDULL);
+    EventInfo eventInfo;
+    std::vector<G4bool> dropped(variations.size(), false);
+    for (G4int i = 0; i < numCollisions; ++i) {
+        eventInfo.index = i;
+        if (bootstrapReplicas > 0) {
+            bootstrapWeights.Draw(i);
+            eventInfo.bootstrapWeights = bootstrapWeights.Get();
+        }
+        const std::size_t slot = beam.Next();
+        for (std::size_t v = 0; v < variations.size(); ++v) {
+            if (dropped[v]) continue;
+            HadronicGenerator* generator = generators[v];
+            HadronicAnalysis* analysis = analyses[v];
+            G4Random::setTheSeed(EventJournal::EventSeed(runSeed, i));
+            auto aChange = generator->GenerateInteraction(projectile, beam.Momentum(slot), material);
+            const G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
+            eventInfo.generator = &generator->GetEventRecord();
+            analysis->BeginEvent(eventInfo);
+            G4ThreeVector cmsBoost;
+            G4double sqrtS = 0.;
+            if (nsec > 0) {
+                const TargetModel::Nucleus& struck =
+                    targets[v].StruckNucleus(generator->GetHadronicProcess());
+                beam.CmsFrame(slot, struck, cmsBoost, sqrtS);
+            }
+            for (G4int j = 0; j < nsec; ++j) {
+                const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+                const auto* pd = sec->GetDefinition();
+                if (!acceptances[v].Accepts(pd->GetPDGEncoding(), sec->GetMomentum())) continue;
+                analysis->Fill(computeObservables(sec->Get4Momentum(), pd, cmsBoost, sqrtS), pd);
+            }
+            if (aChange) aChange->Clear();
+            if (progress) progress->Add(nsec);
+            if (monitors.empty() || !monitors[v]->Poll(*analysis, i + 1)) continue;
+            std::cout << "Dropping variation " << variations[v].tag << ": chi2/ndf cannot end up below "
+                      << chi2Abort << std::endl;
+            dropped[v] = true;
+        }
+        if (progress) progress->Poll();
+    }
+    if (progress) progress->Finish();
+
+    for (std::size_t v = 0; v < variations.size(); ++v) {
+        std::cout << "==== Variation " << v << ": " << variations[v].tag
+                  << (dropped[v] ? " (dropped) ====" : " ====") << std::endl;
+        if (!dropped[v]) {
+            if (!monitors.empty()) monitors[v]->Check(*analyses[v], numCollisions, std::cout);
+            analyses[v]->Finalize();
+            targets[v].Print(std::cout);
+        }
+        UnloadAnalysis(analyses[v], handles[v]);
+    }
+    return 0;
+}
 
 int main(int argc, char** argv) {
     std::string analysisName;
     G4int numCollisions = 1000000;
+    G4bool profileModels = false;
+    G4double progressInterval = 0.;
+    std::string statusFile;
+    G4String nameMaterial = "G4_C";
+    G4double thickness = 0.;
+    G4double beamMomentum = 31.0 * CLHEP::GeV;
+    G4double beamSpread = 0.;
+    G4double beamDivergence = 0.;
+    std::string beamFile;
+    long runSeed = 12345;
+    G4int bootstrapReplicas = 0;
+    std::string journalFile;
+    G4int replay = -1;
+    G4bool dumpSecondaries = false;
+    std::string eventFile;
+    std::string matrixFile;
+    std::string variationsFile;
+    G4String namePhysics = "QGSP";
+    G4bool physicsGiven = false;
+    std::string numaPolicy;
+    std::size_t numaNodes = 0;
+    std::string xsCacheFile;
+    std::string resultCacheDir;
+    std::string liveName;
+    G4double liveInterval = 5.;
+    G4int numForks = 0;
+    G4int numPipelineThreads = 0;
+    std::size_t pipelineBatch = 64;
+    std::size_t pipelineDepth = 0;
+    G4double chi2Abort = 0.;
+    G4int chi2Every = 0;
+    std::size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    enum {
+        kJournal = 1000, kReplayEvent, kDump, kHepMC, kMatrix, kXSCache, kFork, kResultCache, kLive,
+        kLiveInterval, kPipeline, kPipelineBatch, kPipelineDepth, kChi2Abort, kChi2Every,
+        kVariations, kNuma, kNumaNodes, kPhysics
+    };
+    static const option longOptions[] = {
+        {"journal", required_argument, nullptr, kJournal},
+        {"matrix", required_argument, nullptr, kMatrix},
+        {"variations", required_argument, nullptr, kVariations},
+        {"physics", required_argument, nullptr, kPhysics},
+        {"numa", required_argument, nullptr, kNuma},
+        {"numa-nodes", required_argument, nullptr, kNumaNodes},
+        {"xs-cache", required_argument, nullptr, kXSCache},
+        {"fork", required_argument, nullptr, kFork},
+        {"result-cache", required_argument, nullptr, kResultCache},
+        {"live", required_argument, nullptr, kLive},
+        {"live-interval", required_argument, nullptr, kLiveInterval},
+        {"pipeline", required_argument, nullptr, kPipeline},
+        {"pipeline-batch", required_argument, nullptr, kPipelineBatch},
+        {"pipeline-depth", required_argument, nullptr, kPipelineDepth},
+        {"chi2-abort", required_argument, nullptr, kChi2Abort},
+        {"chi2-every", required_argument, nullptr, kChi2Every},
+        {"hepmc", required_argument, nullptr, kHepMC},
+        {"replay-event", required_argument, nullptr, kReplayEvent},
+        {"dump", no_argument, nullptr, kDump},
+        {nullptr, 0, nullptr, 0}};
 
     int opt;
-    while ((opt = getopt(argc, argv, "a:n:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "a:n:tp:s:m:L:k:d:D:B:S:R:j:", longOptions, nullptr)) != -1) {
         if (opt == 'a') analysisName = optarg;
         else if (opt == 'n') numCollisions = std::stoi(optarg);
+        else if (opt == 't') profileModels = true;
+        else if (opt == 'p') progressInterval = std::stod(optarg);
+        else if (opt == 's') statusFile = optarg;
+        else if (opt == 'm') nameMaterial = optarg;
+        else if (opt == 'L') thickness = std::stod(optarg) * CLHEP::cm;
+        else if (opt == 'k') beamMomentum = std::stod(optarg) * CLHEP::GeV;
+        else if (opt == 'd') beamSpread = std::stod(optarg);
+        else if (opt == 'D') beamDivergence = std::stod(optarg) * CLHEP::milliradian;
+        else if (opt == 'B') beamFile = optarg;
+        else if (opt == 'S') runSeed = std::stol(optarg);
+        else if (opt == 'R') bootstrapReplicas = std::max(0, std::stoi(optarg));
+        else if (opt == 'j') numThreads = std::max(1, std::stoi(optarg));
+        else if (opt == kJournal) journalFile = optarg;
+        else if (opt == kReplayEvent) replay = std::stoi(optarg);
+        else if (opt == kDump) dumpSecondaries = true;
+        else if (opt == kHepMC) eventFile = optarg;
+        else if (opt == kMatrix) matrixFile = optarg;
+        else if (opt == kVariations) variationsFile = optarg;
+        else if (opt == kPhysics) {
+            namePhysics = optarg;
+            physicsGiven = true;
+        }
+        else if (opt == kNuma) numaPolicy = optarg;
+        else if (opt == kNumaNodes) numaNodes = std::max(1, std::stoi(optarg));
+        else if (opt == kXSCache) xsCacheFile = optarg;
+        else if (opt == kFork) numForks = std::max(0, std::stoi(optarg));
+        else if (opt == kResultCache) resultCacheDir = optarg;
+        else if (opt == kLive) liveName = optarg;
+        else if (opt == kLiveInterval) liveInterval = std::stod(optarg);
+        else if (opt == kPipeline) numPipelineThreads = std::max(0, std::stoi(optarg));
+        else if (opt == kPipelineBatch) pipelineBatch = std::max(1, std::stoi(optarg));
+        else if (opt == kPipelineDepth) pipelineDepth = std::max(1, std::stoi(optarg));
+        else if (opt == kChi2Abort) chi2Abort = std::stod(optarg);
+        else if (opt == kChi2Every) chi2Every = std::max(1, std::stoi(optarg));
+    }
+    if (!statusFile.empty() && progressInterval <= 0.) progressInterval = 30.;
+
+    if (replay >= 0) {
+        if (journalFile.empty()) {
+            std::cerr << "ERROR: --replay-event needs --journal <file>" << std::endl;
+            return 1;
+        }
+        return replayEvent(journalFile, replay, dumpSecondaries);
     }
 
     if (analysisName.empty()) {
-        std::cerr << "Usage: " << argv[0] << " -a <AnalysisName> [-n Ncoll]" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " -a <AnalysisName|reference.yoda> [-n Ncoll] [-t] [-p seconds] [-s statusFile]"
+                  << " [-m material] [-L thickness] [--physics name]"
+                  << " [-k p] [-d dp/p] [-D divergence] [-B beamFile] [-S seed] [-R replicas]"
+                  << " [--journal file] [--hepmc file[.gz]] [--xs-cache file] [--fork N]"
+                  << " [--result-cache dir] [--live name [--live-interval seconds]]"
+                  << " [--pipeline A [--pipeline-batch N] [--pipeline-depth N]]"
+                  << " [--chi2-abort chi2/ndf [--chi2-every N]]" << std::endl
+                  << "       " << argv[0]
+                  << " -a <AnalysisName|reference.yoda> --matrix file [-j threads] [-S seed] [-R replicas]"
+                  << " [-p seconds] [-s statusFile] [--numa compact|spread [--numa-nodes N]]" << std::endl
+                  << "       " << argv[0]
+                  << " -a <AnalysisName|reference.yoda> --variations file [--physics name] [-n Ncoll]"
+                  << " [-m material]"
+                  << " [-L thickness] [-k p] [-d dp/p] [-D divergence] [-B beamFile] [-S seed] [-R replicas]"
+                  << " [-p seconds] [-s statusFile] [--chi2-abort chi2/ndf [--chi2-every N]]" << std::endl
+                  << "       " << argv[0] << " --journal file --replay-event k [--dump]" << std::endl
+                  << "  -t  per-model GenerateInteraction timing, dumped at the end of the run"
+                  << std::endl
+                  << "  -p  progress report to stderr every <seconds>" << std::endl
+                  << "  -s  also write progress as JSON to <statusFile> (default every 30 s)"
+                  << std::endl
+                  << "  -m  NIST target material, compounds and mixtures included (default G4_C)"
+                  << std::endl
+                  << "  -L  target thickness in cm, reported as the interaction probability only;"
+                  << std::endl
+                  << "      every collision is still generated thin-target (default 0)" << std::endl
+                  << "  -k  nominal beam momentum in GeV/c along +z (default 31)" << std::endl
+                  << "  --physics       physics case, e.g. FTFP_BERT, QGSP_BERT, FTFP, QGSP (default QGSP);"
+                  << " with --matrix it is given per configuration" << std::endl
+                  << "  -d  Gaussian relative momentum spread sigma(p)/p" << std::endl
+                  << "  -D  Gaussian beam divergence per projected angle in mrad" << std::endl
+                  << "  -B  beam file: \"p weight\" spectrum rows or \"px py pz\" particle rows (GeV/c)"
+                  << std::endl
+                  << "  -S  run seed: beam, per-collision Geant4 seeds, bootstrap (default 12345)"
+                  << std::endl
+                  << "  -R  Poisson bootstrap replicas per histogram bin, written next to the"
+                  << " nominal output" << std::endl
+                  << "  --journal       record per-collision seeds and outcomes to <file>" << std::endl
+                  << "  --replay-event  regenerate collision k of a journaled run" << std::endl
+                  << "  --dump          with --replay-event, print every secondary" << std::endl
+                  << "  --hepmc         write every collision as HepMC3 ASCII, from a writer thread"
+                  << std::endl
+                  << "  --matrix        run every configuration of a run matrix, one per line:"
+                  << " \"physics projectile p[GeV/c] material collisions [thickness[cm]] [tag]\""
+                  << std::endl
+                  << "  -j              worker threads for --matrix (default: all cores)" << std::endl
+                  << "  --numa          pin the --matrix workers to NUMA nodes, filling one node after"
+                  << " the other (compact) or round-robin (spread); each worker allocates its own state"
+                  << std::endl
+                  << "  --numa-nodes    use only the first N NUMA nodes (default: all)" << std::endl
+                  << "  --variations    run every model-parameter variation of a file on the same"
+                  << " collisions, one per line: \"tag [name=value ...]\"" << std::endl
+                  << "  --xs-cache      inelastic cross-section grid cache (default"
+                  << " xsec_<physics>_g4<version>.cache)" << std::endl
+                  << "  --fork          initialise once, then run the collisions in N forked worker"
+                  << " processes (progress is worker 0's)" << std::endl
+                  << "  --result-cache  reuse the outputs of an identical earlier run stored in <dir>,"
+                  << " or extend one with fewer collisions" << std::endl
+                  << "  --live          publish the accumulators to shared memory segment <name>"
+                  << " (<name>.<worker> with --fork) for ThinTargetLive" << std::endl
+                  << "  --live-interval seconds between --live snapshots (default 5)" << std::endl
+                  << "  --pipeline      compute observables and fill on A analysis threads, fed with"
+                  << " batches of secondaries by the generation loop" << std::endl
+                  << "  --pipeline-batch collisions per --pipeline batch (default 64)" << std::endl
+                  << "  --pipeline-depth batches in flight before generation waits (default 4 A)"
+                  << std::endl
+                  << "  --chi2-abort    compare to the reference data during the run and stop, without"
+                  << " outputs, once chi2/ndf cannot end up below <chi2/ndf> (with --variations: drop"
+                  << " that variation); an error for an analysis without reference data" << std::endl
+                  << "  --chi2-every    collisions between --chi2-abort comparisons (default 5% of the run)"
+                  << std::endl;
         return 1;
     }
 
-    void* handle = nullptr;
-    std::string libPath;
-
-    // Try LD_LIBRARY_PATH first
-    libPath = "lib" + analysisName + ".so";
-    handle = dlopen(libPath.c_str(), RTLD_LAZY);
-
-    if (!handle) {
-       // Fallback: try local ./plugins directory
-       libPath = "./plugins/lib" + analysisName + ".so";
-       handle = dlopen(libPath.c_str(), RTLD_LAZY);
-   }
-
-
-    HadronicAnalysis* analysis = LoadAnalysis(libPath, &handle);
-    if (!analysis) return 2;
+    if (numForks > 0 && (profileModels || !eventFile.empty())) {
+        std::cerr << "ERROR: -t and --hepmc are not supported with --fork" << std::endl;
+        return 1;
+    }
+    if (!matrixFile.empty() && !liveName.empty()) {
+        std::cerr << "ERROR: --live is not supported with --matrix" << std::endl;
+        return 1;
+    }
+    if (!variationsFile.empty()
+        && (!matrixFile.empty() || numForks > 0 || numPipelineThreads > 0 || !liveName.empty()
+            || !journalFile.empty() || !eventFile.empty() || !resultCacheDir.empty() || profileModels)) {
+        std::cerr << "ERROR: --variations runs on its own: no --matrix, --fork, --pipeline, --live,"
+                  << " --journal, --hepmc, --result-cache or -t" << std::endl;
+        return 1;
+    }
+    if (physicsGiven && !matrixFile.empty()) {
+        std::cerr << "ERROR: --physics is given per configuration in the --matrix file" << std::endl;
+        return 1;
+    }
+    if (!numaPolicy.empty() && matrixFile.empty()) {
+        std::cerr << "ERROR: --numa places the worker threads of --matrix" << std::endl;
+        return 1;
+    }
+    // The comparison reads the accumulators of this process only
+    if (chi2Abort > 0. && variationsFile.empty()
+        && (numForks > 0 || numPipelineThreads > 0 || !matrixFile.empty())) {
+        std::cerr << "ERROR: --chi2-abort is not supported with --fork, --pipeline or --matrix" << std::endl;
+        return 1;
+    }
+    // Snapshots would read the accumulators while the analysis threads fill them
+    if (numPipelineThreads > 0 && (!matrixFile.empty() || !liveName.empty())) {
+        std::cerr << "ERROR: --pipeline is not supported with --matrix or --live" << std::endl;
+        return 1;
+    }
 
-    analysis->Initialize(numCollisions);
+    if (!matrixFile.empty()) {
+        std::unique_ptr<NumaPlacement> placement;
+        if (!numaPolicy.empty()) {
+            NumaPlacement::Policy policy;
+            if (!NumaPlacement::ParsePolicy(numaPolicy, policy)) {
+                std::cerr << "ERROR: Unknown --numa placement " << numaPolicy << std::endl;
+                return 1;
+            }
+            placement = std::make_unique<NumaPlacement>(policy, numaNodes);
+        }
+        return runMatrix(matrixFile, analysisName, numThreads, runSeed, bootstrapReplicas,
+                         progressInterval, statusFile, xsCacheFile, placement.get());
+    }
 
     // Standard Geant4 init
-    G4ParticleTable::GetParticleTable()->SetReadiness();
-    G4LeptonConstructor().ConstructParticle();
-    G4MesonConstructor().ConstructParticle();
-    G4BaryonConstructor().ConstructParticle();
-    G4IonConstructor().ConstructParticle();
-    G4BosonConstructor().ConstructParticle();
-    G4ShortLivedConstructor().ConstructParticle();
+    constructParticles();
 
-    G4HadronicParameters::Instance()->SetEnableHyperNuclei(true);
-
-    G4String namePhysics = "QGSP";
     G4String nameProjectile = "proton";
-    G4String nameMaterial = "G4_C";
 
     G4ParticleDefinition* projectile = G4ParticleTable::GetParticleTable()->FindParticle(nameProjectile);
     if (!projectile) return 1;
 
-    G4double projectileMomentumZ = 31.0 * CLHEP::GeV;
-    G4ThreeVector projectileMomentum(0., 0., projectileMomentumZ);
-    G4double mass = projectile->GetPDGMass();
-    G4double totalEnergy = std::sqrt(projectileMomentum.mag2() + mass * mass);
+    BeamModel beam(projectile, beamMomentum);
+    beam.SetMomentumSpread(beamSpread);
+    beam.SetDivergence(beamDivergence);
+    beam.SetSeed(runSeed);
+    if (!beamFile.empty() && !beam.LoadBeamFile(beamFile)) return 1;
 
     G4Material* material = G4NistManager::Instance()->FindOrBuildMaterial(nameMaterial);
-    const G4Element* element = material->GetElement(0);
-    G4int Z = static_cast<G4int>(element->GetZ());
-    G4int A = (element->GetNumberOfIsotopes() > 0) ? element->GetIsotope(0)->GetN() : G4lrint(element->GetA() / (CLHEP::g / CLHEP::mole));
-    G4double nucleusMass = G4NucleiProperties::GetNuclearMass(A, Z);
+    if (!material) {
+        std::cerr << "ERROR: Unknown material " << nameMaterial << std::endl;
+        return 1;
+    }
 
-    G4LorentzVector proj4mom_lab(projectileMomentum, totalEnergy);
-    G4LorentzVector targ4mom_lab(G4ThreeVector(0., 0., 0.), nucleusMass);
-    G4LorentzVector labv = proj4mom_lab + targ4mom_lab;
-    G4ThreeVector cmsBoost = labv.boostVector();
+    if (!variationsFile.empty()) {
+        return runVariations(variationsFile, analysisName, numCollisions, runSeed, bootstrapReplicas,
+                             progressInterval, statusFile, xsCacheFile, namePhysics, projectile, material,
+                             thickness, beam, chi2Abort, chi2Every);
+    }
+
+    void* handle = nullptr;
+    HadronicAnalysis* analysis = LoadAnalysisByName(analysisName, &handle);
+    if (!analysis) return 2;
+
+    // The key is everything that determines the outputs except the number of
+    // collisions. Runs split differently (forks, cache extensions) count as
+    // equivalent: they share the per-collision seeds, only the beam streams differ.
+    std::unique_ptr<ResultCache> resultCache;
+    std::int64_t cachedCollisions = 0;
+    if (!resultCacheDir.empty() && analysis->GetOutputFiles().empty()) {
+        std::cerr << "WARNING: " << analysis->GetName() << " names no output files, results are not cached"
+                  << std::endl;
+    }
+    else if (!resultCacheDir.empty()) {
+        resultCache = std::make_unique<ResultCache>(resultCacheDir);
+        resultCache->Add("format", "ThinTargetSim results 1");
+        resultCache->Add("geant4", std::to_string(G4VERSION_NUMBER));
+        G4bool ok = resultCache->AddFile("executable", "/proc/self/exe");
+        resultCache->Add("analysis", analysisName);
+        const std::string library = AnalysisLibraryPath(handle);
+        if (!library.empty()) ok = ok && resultCache->AddFile("analysis library", library);
+        for (const auto& file : analysis->GetInputFiles()) {
+            ok = ok && resultCache->AddFile("input " + file, file);
+        }
+        resultCache->Add("physics", namePhysics);
+        resultCache->Add("projectile", nameProjectile);
+        resultCache->Add("momentum [MeV/c]", beamMomentum);
+        resultCache->Add("momentum spread", beamSpread);
+        resultCache->Add("divergence [rad]", beamDivergence);
+        if (!beamFile.empty()) ok = ok && resultCache->AddFile("beam file", beamFile);
+        resultCache->Add("material", nameMaterial);
+        resultCache->Add("thickness [mm]", thickness);
+        resultCache->Add("seed", std::to_string(runSeed));
+        resultCache->Add("bootstrap replicas", std::to_string(bootstrapReplicas));
+        if (!ok) resultCache.reset();
+    }
+    // A journal or event file needs every collision generated by this run
+    if (resultCache && journalFile.empty() && eventFile.empty()) {
+        cachedCollisions = resultCache->Lookup(numCollisions);
+        if (cachedCollisions == numCollisions) {
+            std::cout << "Result cache hit: " << resultCache->Key() << ", " << numCollisions
+                      << " collisions" << std::endl;
+            if (resultCache->Restore(numCollisions)) {
+                UnloadAnalysis(analysis, handle);
+                return 0;
+            }
+            cachedCollisions = 0;
+        }
+    }
 
     HadronicGenerator* theHadronicGenerator = new HadronicGenerator(namePhysics);
     if (!theHadronicGenerator->IsPhysicsCaseSupported()) return 3;
 
-    for (G4int i = 0; i < numCollisions; ++i) {
-        auto aChange = theHadronicGenerator->GenerateInteraction(projectile, projectileMomentum, material);
+    // Boost and sqrt(s) of every nucleus in the target, looked up per event
+    TargetModel target(material, thickness);
+    target.Prepare(*theHadronicGenerator, projectile, G4ThreeVector(0., 0., beamMomentum));
+    beam.SetTarget(target);
+
+    CrossSectionTable crossSections(namePhysics, xsCacheFile);
+    crossSections.Require(*theHadronicGenerator, {{projectile, material}});
+
+    RunInfo runInfo;
+    runInfo.numCollisions = numCollisions;
+    runInfo.inelasticXS = crossSections.Inelastic(projectile, material, beamMomentum);
+    runInfo.bootstrapReplicas = bootstrapReplicas;
+    analysis->SetRunInfo(runInfo);
+    analysis->Initialize(numCollisions);
+    // Secondaries outside the analysis acceptance never reach computeObservables
+    const AcceptanceFilter acceptance(analysis->GetAcceptance());
+
+    // A cached run with fewer collisions is the starting point: only the
+    // missing collisions are generated, with a beam stream of their own. Its
+    // state is added at the end, so that forked workers do not inherit it.
+    G4int firstCollision = 0;
+    long beamSeed = runSeed;
+    std::vector<std::vector<G4double>> cachedState;
+    if (cachedCollisions > 0) {
+        if (resultCache->LoadState(cachedCollisions, cachedState)
+            && matchesRunState(cachedState, *analysis)) {
+            std::cout << "Result cache: extending " << resultCache->Key() << " from " << cachedCollisions
+                      << " to " << numCollisions << " collisions" << std::endl;
+            firstCollision = static_cast<G4int>(cachedCollisions);
+            beamSeed = static_cast<long>(
+                EventJournal::EventSeed(runSeed, -(std::int64_t(1) << 40) - cachedCollisions));
+            beam.SetSeed(beamSeed);
+            beam.SetFirstEvent(firstCollision);
+        }
+        else {
+            cachedState.clear();
+            std::cerr << "WARNING: Cached state of " << resultCache->Key() << " does not match "
+                      << analysis->GetName() << ", running all collisions" << std::endl;
+        }
+    }
+
+    std::unique_ptr<EventJournal> journal;
+    if (!journalFile.empty()) {
+        journal = std::make_unique<EventJournal>();
+        if (!journal->Create(journalFile, EventJournal::MakeHeader(runSeed, numCollisions, namePhysics,
+                                                                   nameProjectile, nameMaterial, thickness))) {
+            return 1;
+        }
+    }
+
+    // With --fork everything above is done once and shared copy-on-write by
+    // the workers, each of which runs a contiguous range of collisions. The
+    // journal mapping is shared too: the workers write disjoint records.
+    G4int endCollision = numCollisions;
+    G4int worker = -1;
+    std::unique_ptr<ForkPool> workers;
+    if (numForks > 0) {
+        if (analysis->Accumulators().empty()) {
+            std::cerr << "ERROR: " << analysis->GetName() << " has no accumulators to merge,"
+                      << " it cannot run with --fork" << std::endl;
+            return 2;
+        }
+        // One collision before forking, so that lazily built model state is shared as well
+        G4Random::setTheSeed(EventJournal::EventSeed(runSeed, -1));
+        auto warmUp = theHadronicGenerator->GenerateInteraction(
+            projectile, G4ThreeVector(0., 0., beamMomentum), material);
+        if (warmUp) warmUp->Clear();
+
+        workers = std::make_unique<ForkPool>(numForks);
+        worker = workers->Start();
+        if (worker == -2) return 4;
+        if (worker >= 0) {
+            const std::int64_t first = firstCollision;
+            const std::int64_t n = numCollisions - first;
+            firstCollision = static_cast<G4int>(first + n * worker / numForks);
+            endCollision = static_cast<G4int>(first + n * (worker + 1) / numForks);
+            beam.SetSeed(static_cast<long>(EventJournal::EventSeed(beamSeed, -2 - worker)));
+            beam.SetFirstEvent(firstCollision);
+        }
+        else {
+            endCollision = firstCollision;
+        }
+    }
+
+    // Snapshots of this process' accumulators for ThinTargetLive; failing to
+    // publish them is not a reason to stop the run
+    std::unique_ptr<LiveSnapshot> live;
+    if (!liveName.empty() && endCollision > firstCollision) {
+        const std::string segment = worker >= 0 ? liveName + "." + std::to_string(worker) : liveName;
+        live = std::make_unique<LiveSnapshot>(segment, liveInterval);
+        if (!live->Open(*analysis, analysisName, endCollision - firstCollision)) live.reset();
+    }
+
+    // Analysis threads start after the fork: threads do not survive it. Each
+    // thread fills an instance of its own, merged into `analysis` by Finish().
+    std::vector<HadronicAnalysis*> pipelineAnalyses;
+    std::vector<void*> pipelineHandles;
+    std::unique_ptr<AnalysisPipeline> pipeline;
+    if (numPipelineThreads > 0 && endCollision > firstCollision) {
+        pipelineAnalyses.push_back(analysis);
+        pipelineHandles.push_back(handle);
+        for (G4int t = 1; t < numPipelineThreads; ++t) {
+            void* extraHandle = nullptr;
+            HadronicAnalysis* extra = LoadAnalysisByName(analysisName, &extraHandle);
+            if (!extra) return 2;
+            extra->SetRunInfo(runInfo);
+            extra->Initialize(numCollisions);
+            pipelineAnalyses.push_back(extra);
+            pipelineHandles.push_back(extraHandle);
+        }
+        if (numPipelineThreads > 1 && analysis->Accumulators().empty()) {
+            std::cerr << "ERROR: " << analysis->GetName() << " has no accumulators to merge,"
+                      << " run it with --pipeline 1" << std::endl;
+            return 2;
+        }
+        if (pipelineDepth == 0) pipelineDepth = 4 * static_cast<std::size_t>(numPipelineThreads);
+        pipeline = std::make_unique<AnalysisPipeline>(pipelineAnalyses, pipelineBatch, pipelineDepth,
+                                                      bootstrapReplicas,
+                                                      static_cast<std::uint64_t>(runSeed) ^ 0xB0075EEDULL);
+    }
+
+    std::unique_ptr<Chi2Monitor> chi2Monitor;
+    if (chi2Abort > 0. && endCollision > firstCollision) {
+        const std::int64_t n = endCollision - firstCollision;
+        chi2Monitor = std::make_unique<Chi2Monitor>(chi2Abort, chi2Every > 0 ? chi2Every : (n + 19) / 20, n);
+        if (!chi2Monitor->IsEnabled(*analysis)) {
+            std::cerr << "ERROR: " << analysis->GetName() << " has no reference points to compare to,"
+                      << " --chi2-abort cannot be used" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<ModelTimingProfiler> profiler;
+    if (profileModels) profiler = std::make_unique<ModelTimingProfiler>();
+    std::unique_ptr<ProgressMonitor> progress;
+    if (progressInterval > 0. && worker <= 0 && endCollision > firstCollision) {
+        progress = std::make_unique<ProgressMonitor>(endCollision - firstCollision, progressInterval,
+                                                     statusFile);
+    }
+
+    std::unique_ptr<HepMCWriter> eventWriter;
+    if (!eventFile.empty()) {
+        eventWriter = std::make_unique<HepMCWriter>(eventFile);
+        if (!eventWriter->IsOpen()) return 1;
+    }
+
+    AllocationReport allocReport;
+    // Replica weights come from their own stream, so the nominal results do
+    // not depend on whether bootstrapping is enabled
+    BootstrapWeights bootstrapWeights(bootstrapReplicas, static_cast<std::uint64_t>(runSeed) ^ 0xB0075EEDULL);
+    EventInfo eventInfo;
+    G4bool aborted = false;
+
+    for (G4int i = firstCollision; i < endCollision; ++i) {
+        if (AllocationTracker::kEnabled) {
+            allocReport.BeginEvent();
+            AllocationTracker::SetPhase(AllocationTracker::kGeneration);
+        }
+        eventInfo.index = i;
+        if (bootstrapReplicas > 0 && !pipeline) {
+            bootstrapWeights.Draw(i);
+            eventInfo.bootstrapWeights = bootstrapWeights.Get();
+        }
+        const std::size_t slot = beam.Next();
+        // Every collision starts from its own seed, so that it can be replayed alone
+        const std::uint64_t seed = EventJournal::EventSeed(runSeed, i);
+        G4Random::setTheSeed(seed);
+        if (journal) journal->Begin(i, seed, beam.Momentum(slot));
+
+        std::chrono::steady_clock::time_point start;
+        if (profiler || journal) start = std::chrono::steady_clock::now();
+        auto aChange = theHadronicGenerator->GenerateInteraction(projectile, beam.Momentum(slot), material);
         G4int nsec = aChange ? aChange->GetNumberOfSecondaries() : 0;
-        for (G4int j = 0; j < nsec; ++j) {
+        const HadronicEventRecord& record = theHadronicGenerator->GetEventRecord();
+        std::int64_t ns = 0;
+        if (profiler || journal) {
+            ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        if (profiler) {
+            profiler->Record(record.model, beam.KineticEnergy(slot), ns, nsec);
+        }
+        if (!pipeline) {
+            eventInfo.generator = &record;
+            analysis->BeginEvent(eventInfo);
+        }
+        G4ThreeVector cmsBoost;
+        G4double sqrtS = 0.;
+        G4int nucleus = 0;
+        const TargetModel::Nucleus* struck = nullptr;
+        if (nsec > 0) {
+            struck = &target.StruckNucleus(theHadronicGenerator->GetHadronicProcess());
+            beam.CmsFrame(slot, *struck, cmsBoost, sqrtS);
+            nucleus = 1000 * struck->Z + struck->A;
+        }
+        if (eventWriter) {
+            // Every collision is exported, empty ones included.
+            // Only copies here: formatting, compression and I/O are on the writer thread
+            ExportedEvent& event = eventWriter->Acquire();
+            const G4ThreeVector p = beam.Momentum(slot);
+            const G4double mass = projectile->GetPDGMass();
+            event.number = i;
+            event.beam = {projectile->GetPDGEncoding(), p.x(), p.y(), p.z(),
+                          beam.KineticEnergy(slot) + mass, mass};
+            if (struck) {
+                event.target = {1000000000 + 10000 * struck->Z + 10 * struck->A, 0., 0., 0.,
+                                struck->mass, struck->mass};
+            } else if (record.targetZ > 0) {
+                // No secondaries: the process still knows the nucleus it sampled
+                const G4double targetMass =
+                    G4NucleiProperties::GetNuclearMass(record.targetA, record.targetZ);
+                event.target = {1000000000 + 10000 * record.targetZ + 10 * record.targetA, 0., 0., 0.,
+                                targetMass, targetMass};
+            } else {
+                // No collision at all: the target is unknown
+                event.target = {0, 0., 0., 0., 0., 0.};
+            }
+            event.model = record.model ? record.model->GetModelName() : G4String("none");
+            event.impactParameter = record.impactParameter;
+            event.numNNcollisions = record.numNNcollisions;
+            event.projectileSpectators = record.numProjectileSpectatorNucleons;
+            event.targetSpectators = record.numTargetSpectatorNucleons;
+            for (G4int j = 0; j < nsec; ++j) {
+                const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+                const G4LorentzVector p4 = sec->Get4Momentum();
+                event.secondaries.push_back({sec->GetDefinition()->GetPDGEncoding(), p4.px(), p4.py(),
+                                             p4.pz(), p4.e(), sec->GetMass()});
+            }
+            eventWriter->Publish();
+        }
+        if (journal) journal->End(i, nsec, nucleus, ns);
+        if (pipeline) {
+            // Copies only; the observables are computed on the analysis threads
+            pipeline->BeginEvent(i, record, cmsBoost, sqrtS);
+            for (G4int j = 0; j < nsec; ++j) {
+                const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
+                const auto* pd = sec->GetDefinition();
+                if (acceptance.Accepts(pd->GetPDGEncoding(), sec->GetMomentum())) {
+                    pipeline->AddSecondary(pd, sec->Get4Momentum());
+                }
+            }
+            pipeline->EndEvent();
+        }
+        for (G4int j = 0; j < nsec && !pipeline; ++j) {
             const auto* sec = aChange->GetSecondary(j)->GetDynamicParticle();
             const auto* pd = sec->GetDefinition();
+            if (!acceptance.Accepts(pd->GetPDGEncoding(), sec->GetMomentum())) continue;
             const G4LorentzVector p4 = sec->Get4Momentum();
-            Observables obs = computeObservables(p4, pd, cmsBoost, labv.mag());
+            AllocationTracker::SetPhase(AllocationTracker::kObservables);
+            Observables obs = computeObservables(p4, pd, cmsBoost, sqrtS);
+            AllocationTracker::SetPhase(AllocationTracker::kFill);
             analysis->Fill(obs, pd);
         }
+        // The secondaries are owned by the particle change: releasing them is generation cost
+        AllocationTracker::SetPhase(AllocationTracker::kGeneration);
         if (aChange) aChange->Clear();
+        if (AllocationTracker::kEnabled) allocReport.EndEvent();
+        if (progress) {
+            progress->Add(nsec);
+            progress->Poll();
+        }
+        if (live) live->Poll(i + 1 - firstCollision);
+        if (chi2Monitor && chi2Monitor->Poll(*analysis, i + 1 - firstCollision)) {
+            aborted = true;
+            break;
+        }
+    }
+    if (progress) progress->Finish();
+    if (pipeline) {
+        const G4bool merged = pipeline->Finish();
+        if (worker <= 0) pipeline->PrintStatistics(std::cout);
+        pipeline.reset();
+        for (std::size_t t = 1; t < pipelineAnalyses.size(); ++t) {
+            UnloadAnalysis(pipelineAnalyses[t], pipelineHandles[t]);
+        }
+        if (!merged) {
+            std::cerr << "ERROR: Results of the analysis threads could not be merged" << std::endl;
+            return 4;
+        }
+    }
+    // The segment goes with the run; forked workers _exit without destructors
+    live.reset();
+    if (eventWriter) {
+        eventWriter->Close();
+        eventWriter->PrintStatistics(std::cout);
+    }
+    if (aborted) {
+        // Nothing is written or cached: the outputs would be those of a partial run
+        std::cout << "Aborted: chi2/ndf cannot end up below " << chi2Abort << std::endl;
+        UnloadAnalysis(analysis, handle);
+        return 5;
+    }
+    if (chi2Monitor) chi2Monitor->Check(*analysis, endCollision - firstCollision, std::cout);
+
+    if (workers) {
+        if (worker >= 0) {
+            // The parent generates nothing: worker 0 reports for the run
+            if (AllocationTracker::kEnabled && worker == 0) allocReport.Print(std::cout);
+            G4bool ok = true;
+            for (const auto& array : runState(*analysis, target)) {
+                ok = ok && workers->Send(array.data(), array.size());
+            }
+            workers->Exit(ok);
+        }
+        G4bool ok = true;
+        std::vector<std::vector<G4double>> state(analysis->Accumulators().size() + 1);
+        for (std::size_t w = 0; w < workers->GetNumWorkers() && ok; ++w) {
+            for (auto& array : state) ok = ok && workers->Receive(w, array);
+            ok = ok && addRunState(state, *analysis, target);
+        }
+        ok = workers->Wait() && ok;
+        if (!ok) {
+            std::cerr << "ERROR: Results of the forked workers are incomplete" << std::endl;
+            return 4;
+        }
     }
 
+    if (!cachedState.empty()) addRunState(cachedState, *analysis, target);
+    // Taken before Finalize, which need not leave the accumulators untouched
+    std::vector<std::vector<G4double>> finalState;
+    if (resultCache) finalState = runState(*analysis, target);
     analysis->Finalize();
+    if (resultCache) resultCache->Store(numCollisions, finalState, analysis->GetOutputFiles());
+    target.Print(std::cout);
+    if (profiler) profiler->Dump(std::cout);
+    if (AllocationTracker::kEnabled) allocReport.Print(std::cout);
     UnloadAnalysis(analysis, handle);
     return 0;
 }
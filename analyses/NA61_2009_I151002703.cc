@@ -1,20 +1,110 @@
 #include "HadronicAnalysis.hh"
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <vector>
 #include <iostream>
 #include <iomanip>
-#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include "YODA/Histo.h"
 #include "YODA/WriterYODA.h"
 #include "YODA/ReaderYODA.h"
+#include "BootstrapReplicas.hh"
+#include "HistogramSelection.hh"
 #include "HistogramUtils.hh"
 
-class NA61_2009_I151002703 : public HadronicAnalysis {
+namespace {
+
+// Momentum edges in GeV/c of the published slices, as in NA61_2009_I151002703.yoda.
+// Initialize checks them against the reference file.
+inline constexpr std::array<double, 40> kPiPlus0To10{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.6, 2.0, 2.4, 2.8, 3.2, 3.6, 4.0, 4.4,
+    4.8, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6, 8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8, 11.6, 12.4,
+    13.2, 14.0, 14.8, 15.6, 16.4};
+inline constexpr std::array<double, 47> kPiPlus10To40{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.6, 2.0, 2.4, 2.8, 3.2, 3.6, 4.0, 4.4,
+    4.8, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6, 8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8, 11.6, 12.4,
+    13.2, 14.0, 14.8, 15.6, 16.4, 17.2, 18.0, 18.8, 19.6, 20.4, 21.2, 22.0};
+inline constexpr std::array<double, 55> kPi40To60{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6,
+    8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8, 11.6, 12.4, 13.2, 14.0, 14.8, 15.6, 16.4, 17.2, 18.0,
+    18.8, 19.6, 20.4};
+inline constexpr std::array<double, 52> kPiPlus60To100{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6,
+    8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8, 11.6, 12.4, 13.2, 14.0, 14.8, 15.6, 16.4, 17.2, 18.0};
+inline constexpr std::array<double, 47> kPiPlus100To140{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6,
+    8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8, 11.6, 12.4, 13.2, 14.0};
+inline constexpr std::array<double, 43> kPiPlus140To180{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6,
+    8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8};
+inline constexpr std::array<double, 37> kPiPlus180To240{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6,
+    8.0};
+inline constexpr std::array<double, 29> kPiPlus240To300{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0, 3.2, 3.4, 3.6, 3.8, 4.0, 4.2, 4.4, 4.6, 4.8, 5.0};
+inline constexpr std::array<double, 19> kPiPlus300To360{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.0};
+inline constexpr std::array<double, 9> kPiPlus360To420{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0};
+inline constexpr std::array<double, 43> kPiMinus0To10{
+    0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8, 3.2,
+    3.6, 4.0, 4.4, 4.8, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6, 8.0, 8.4, 8.8, 9.2, 9.6, 10.0, 10.8,
+    11.6, 12.4, 13.2, 14.0, 14.8, 15.6, 16.4};
+inline constexpr std::array<double, 50> kPiMinus10To40{
+    0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4, 2.6, 2.8,
+    3.2, 3.6, 4.0, 4.4, 4.8, 5.2, 5.6, 6.0, 6.4, 6.8, 7.2, 7.6, 8.0, 8.4, 8.8, 9.2, 9.6, 10.0,
+    10.8, 11.6, 12.4, 13.2, 14.0, 14.8, 15.6, 16.4, 17.2, 18.0, 18.8, 19.6, 20.4, 21.2};
+
+using PiPlus = Selection::Species<211,
+    Selection::ThetaSlice<0, 10, kPiPlus0To10>,
+    Selection::ThetaSlice<10, 20, kPiPlus10To40>,
+    Selection::ThetaSlice<20, 40, kPiPlus10To40>,
+    Selection::ThetaSlice<40, 60, kPi40To60>,
+    Selection::ThetaSlice<60, 100, kPiPlus60To100>,
+    Selection::ThetaSlice<100, 140, kPiPlus100To140>,
+    Selection::ThetaSlice<140, 180, kPiPlus140To180>,
+    Selection::ThetaSlice<180, 240, kPiPlus180To240>,
+    Selection::ThetaSlice<240, 300, kPiPlus240To300>,
+    Selection::ThetaSlice<300, 360, kPiPlus300To360>,
+    Selection::ThetaSlice<360, 420, kPiPlus360To420>>;
+using PiMinus = Selection::Species<-211,
+    Selection::ThetaSlice<0, 10, kPiMinus0To10>,
+    Selection::ThetaSlice<10, 20, kPiMinus10To40>,
+    Selection::ThetaSlice<20, 40, kPiMinus10To40>,
+    Selection::ThetaSlice<40, 60, kPi40To60>>;
+using Cuts = Selection::SpeciesSet<PiPlus, PiMinus>;
+
+bool sameEdges(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(a[i] - b[i]) > 1e-9 * std::max(1., std::abs(b[i]))) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+class NA61_2009_I151002703 final : public HadronicAnalysis {
 public:
     void Initialize(G4int numCollisions) override {
         std::cout << GetName() << std::endl;
         std::vector<YODA::AnalysisObject*> aovec;
         YODA::ReaderYODA::create().read(GetName() + ".yoda", aovec);
 
+        // The binning is fixed at compile time by Cuts; the reference file
+        // supplies the output paths, annotations and data points of each slice
+        _slices = Cuts::Slices();
+        _outputs.assign(_slices.size(), {});
         for (auto* ao : aovec) {
             const auto* est = dynamic_cast<const YODA::Estimate1D*>(ao);
             if (!est) {
@@ -23,56 +113,181 @@ public:
             }
             if (!ao->hasAnnotation("Theta range") || !ao->hasAnnotation("Secondary")) continue;
 
-            auto* hist = new YODA::Histo1D(est->xEdges());
+            std::vector<std::pair<std::string, std::string>> annotations;
             std::cout << "Looping over annotations for histogram..." << std::endl;
             for (const auto& key : ao->annotations()) {
-                hist->addAnnotation(key, ao->annotation(key));
+                annotations.emplace_back(key, ao->annotation(key));
                 std::cout << key << ": " << ao->annotation(key) << std::endl;
             }
 
+            const int pdg = pdgFromName(ao->annotation("Secondary"));
+            const auto [theta_min, theta_max] = parseThetaRange(ao->annotation("Theta range"));
+            const auto slice = std::find_if(_slices.begin(), _slices.end(), [&](const auto& s) {
+                return s.pdg == pdg && s.thetaMin == theta_min && s.thetaMax == theta_max;
+            });
+            if (slice == _slices.end()) {
+                throw std::runtime_error(GetName() + ": no compile-time slice for " + est->path());
+            }
+            const std::vector<double> edges = est->xEdges();
+            if (!sameEdges(edges, slice->edges)) {
+                throw std::runtime_error(GetName() + ": momentum edges of " + est->path()
+                                         + " differ from its compile-time slice");
+            }
+            SliceOutput& output = _outputs[slice - _slices.begin()];
+            output.path = est->path();
+            output.annotations = std::move(annotations);
+            output.reference.clear();
+            for (std::size_t i = 0; i + 1 < edges.size(); ++i) {
+                // Bin 0 is the underflow
+                const auto& bin = est->bin(i + 1);
+                output.reference.push_back({bin.val(), bin.totalErrAvg(), edges[i + 1] - edges[i]});
+            }
+
             std::cout << "Histo added" << std::endl;
-            _histos.push_back(hist);
+        }
+        for (std::size_t s = 0; s < _slices.size(); ++s) {
+            if (_outputs[s].path.empty()) {
+                throw std::runtime_error(GetName() + ": no reference data for pdg "
+                                         + std::to_string(_slices[s].pdg) + ", "
+                                         + _slices[s].Label());
+            }
+        }
+        if (GetRunInfo().bootstrapReplicas > 0) {
+            _replicas.Book(Cuts::kNumBins, GetRunInfo().bootstrapReplicas);
         }
 
         _nCollisions = numCollisions;
     }
 
-    void Fill(const Observables& obs, const G4ParticleDefinition* pd) override {
-        if (pd->GetPDGEncoding() != -211 && pd->GetPDGEncoding() != 211) return;
+    void BeginEvent(const EventInfo& event) override {
+        _bootstrapWeights = event.bootstrapWeights;
+    }
 
+    void Fill(const Observables& obs, const G4ParticleDefinition* pd) override {
         const G4double theta_mrad = obs.theta_lab * 1000.0;
         const G4double p = obs.p_lab.mag() / CLHEP::GeV;
 
-        for (auto* hist : _histos) {
-            auto [theta_min, theta_max] = parseThetaRange(hist->annotation("Theta range"));
-            int pdg = pdgFromName(hist->annotation("Secondary"));
-            if (pd->GetPDGEncoding() != pdg) continue;
-            if (theta_mrad >= theta_min && theta_mrad < theta_max) {
-                hist->fill(p, 1.0);
-                break;
+        const int bin = _acc.Fill(pd->GetPDGEncoding(), theta_mrad, p);
+        if (bin >= 0 && _bootstrapWeights && _replicas.Enabled()) {
+            _replicas.Fill(bin, _bootstrapWeights);
+        }
+    }
+
+    AnalysisAcceptance GetAcceptance() const override {
+        AnalysisAcceptance acceptance;
+        acceptance.pdgCodes.assign(Cuts::kPdgCodes.begin(), Cuts::kPdgCodes.end());
+        acceptance.maxThetaLab = Cuts::kThetaMax * CLHEP::milliradian;
+        acceptance.minMomentum = Cuts::kMomentumMin * CLHEP::GeV;
+        acceptance.maxMomentum = Cuts::kMomentumMax * CLHEP::GeV;
+        return acceptance;
+    }
+
+    std::vector<AccumulatorBlock> Accumulators() override {
+        std::vector<AccumulatorBlock> blocks{{_acc.Data(), _acc.DataSize()}};
+        if (_replicas.Enabled()) blocks.push_back({_replicas.Data(), _replicas.DataSize()});
+        return blocks;
+    }
+
+    std::vector<ReferencePoint> CompareToReference(G4int numCollisions) const override {
+        // The normalisation of Finalize, for the collisions so far
+        std::vector<ReferencePoint> points;
+        const G4double sigma_mb = GetRunInfo().inelasticXS / CLHEP::millibarn;
+        if (!(sigma_mb > 0.) || numCollisions <= 0) return points;
+        for (std::size_t s = 0; s < _slices.size(); ++s) {
+            const Selection::SliceInfo& slice = _slices[s];
+            const G4double scale = sigma_mb / (numCollisions * dthetaRad(slice));
+            for (std::size_t i = 0; i < slice.NumBins(); ++i) {
+                const ReferenceBin& ref = _outputs[s].reference[i];
+                const auto& m = _acc[slice.firstBin + i];
+                const G4double w = scale / ref.width;
+                // An empty bin gets the variance of one entry, not zero
+                points.push_back({ref.value, ref.error, m[1] * w, std::max(m[2], 1.) * w * w});
             }
         }
+        return points;
     }
 
     void Finalize() override {
-        const G4double dtheta_rad = 60.0 * CLHEP::milliradian;
-        std::vector<YODA::AnalysisObject*> out;
-        for (auto* hist : _histos) {
-            out.push_back(hist);
+        // Counts are scaled by sigma_inel / N per collision and 1 / dtheta of the
+        // slice. A Histo1D stores sums of weights: YODA does not divide by the
+        // momentum bin width on write, mkEstimate() and the plotting tools do,
+        // which gives d2sigma/(dp dtheta) in mb/(GeV/c rad) as CompareToReference
+        // computes it. The bootstrap Estimate1Ds are written already divided.
+        const G4double sigma_mb = GetRunInfo().inelasticXS / CLHEP::millibarn;
+        const G4bool normalise = sigma_mb > 0. && _nCollisions > 0;
+        if (!normalise) {
+            std::cerr << "Warning: no inelastic cross section, writing raw counts" << std::endl;
         }
-        YODA::WriterYODA::create().write(GetName() + ".yoda", out);
-        std::cout << "Saved YODA histogram" << std::endl;
+        // One Histo1D per slice, in the flat bin order of _replicas
+        std::vector<YODA::Histo1D*> histos;
+        std::vector<double> scales;
+        for (std::size_t s = 0; s < _slices.size(); ++s) {
+            const SliceOutput& output = _outputs[s];
+            auto* histo = new YODA::Histo1D(_slices[s].edges);
+            histo->setPath(output.path);
+            for (const auto& [key, value] : output.annotations) histo->addAnnotation(key, value);
+            _acc.SetBins(_slices[s], *histo);
+            const double scale = normalise ? sigma_mb / (_nCollisions * dthetaRad(_slices[s])) : 1.;
+            if (scale != 1.) histo->scaleW(scale);
+            histos.push_back(histo);
+            scales.push_back(scale);
+        }
+
+        // Never GetName() + ".yoda": without an output tag that is the reference
+        const std::string base = GetOutputName() + "_MC";
+        const std::vector<YODA::AnalysisObject*> out(histos.begin(), histos.end());
+        YODA::WriterYODA::create().write(base + ".yoda", out);
+        std::cout << "Saved " << base << ".yoda" << std::endl;
+
+        if (_replicas.Enabled()) {
+            writeBootstrap(base, histos, _replicas, scales);
+            std::cout << "Saved " << base << "_bootstrap.yoda" << std::endl;
+        }
+        for (auto* hist : histos) delete hist;
     }
 
     std::string GetName() const override {
         return "NA61_2009_I151002703";
     }
 
+    std::vector<std::string> GetOutputFiles() const override {
+        const std::string base = GetOutputName() + "_MC";
+        std::vector<std::string> files{base + ".yoda"};
+        if (GetRunInfo().bootstrapReplicas > 0) {
+            for (auto& file : bootstrapFiles(base)) files.push_back(file);
+        }
+        return files;
+    }
+
+    std::vector<std::string> GetInputFiles() const override {
+        return {GetName() + ".yoda"};
+    }
+
 private:
+    struct ReferenceBin {
+        double value;
+        double error;
+        double width;
+    };
+
+    // Booking of one reference slice; the Histo1D is only built at Finalize
+    struct SliceOutput {
+        std::string path;
+        std::vector<std::pair<std::string, std::string>> annotations;
+        std::vector<ReferenceBin> reference;  // data points, one per momentum bin
+    };
+
+    static G4double dthetaRad(const Selection::SliceInfo& slice) {
+        return (slice.thetaMax - slice.thetaMin) * 1e-3;
+    }
+
     G4int _nCollisions = 0;
-    std::vector<YODA::Histo1D*> _histos;
+    // The only fill target: every (pdg, theta, p) bin of Cuts in one flat array
+    Selection::Accumulator<Cuts> _acc;
+    std::vector<Selection::SliceInfo> _slices;  // Cuts::Slices()
+    std::vector<SliceOutput> _outputs;          // indexed like _slices
+    BootstrapReplicas _replicas;
+    const std::uint8_t* _bootstrapWeights = nullptr;
 };
 
-extern "C" HadronicAnalysis* CreateAnalysis() {
-    return new NA61_2009_I151002703();
-}
+DECLARE_HADRONIC_ANALYSIS(NA61_2009_I151002703)
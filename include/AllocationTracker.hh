@@ -0,0 +1,79 @@
+#ifndef ALLOCATION_TRACKER_HH
+#define ALLOCATION_TRACKER_HH
+
+#include "globals.hh"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Opt-in heap accounting (CMake option WITH_ALLOC_TRACKING, which defines
+// THINTARGET_ALLOC_TRACKING). In that build the global operator new/delete are
+// replaced by counting versions that attribute every allocation to the phase
+// currently set on the calling thread. The phase is per thread; the counters
+// are shared by all threads of the process (relaxed atomics), so the analysis
+// threads of --pipeline and the --matrix workers, which set their own phases,
+// are included. Without the option every call below compiles to nothing, so
+// the driver can be instrumented unconditionally.
+namespace AllocationTracker {
+
+enum Phase : int { kOther = 0, kGeneration, kObservables, kFill, kNumPhases };
+
+struct Counters {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytesAllocated = 0;
+    std::uint64_t bytesFreed = 0;
+};
+
+using Snapshot = std::array<Counters, kNumPhases>;
+
+#ifdef THINTARGET_ALLOC_TRACKING
+constexpr bool kEnabled = true;
+void SetPhase(Phase phase);
+Snapshot Read();
+#else
+constexpr bool kEnabled = false;
+inline void SetPhase(Phase) {}
+inline Snapshot Read() { return {}; }
+#endif
+
+const char* PhaseName(Phase phase);
+
+}  // namespace AllocationTracker
+
+// Per-event bookkeeping on top of the raw counters: allocations and bytes per
+// phase and per event, steady-state allocations per collision after a warm-up,
+// and a least-squares fit of live heap bytes versus event number to flag
+// memory that grows without ever being freed.
+//
+// Events are delimited on the driver thread. With --pipeline the observables
+// and fill allocations of the analysis threads are counted at the event the
+// driver is generating when they happen, so the run and steady-state totals
+// are exact but the per-event maximum of those phases is not. With --fork each
+// process counts its own collisions and worker 0 prints its report. --matrix
+// has no per-event bookkeeping and prints the run totals only (PrintRun).
+class AllocationReport {
+public:
+    explicit AllocationReport(G4int warmupEvents = 100, G4int checkpointEvery = 1000);
+
+    void BeginEvent();
+    void EndEvent();
+    void Print(std::ostream& os) const;
+
+    /// Per-phase totals of the whole run, warm-up included, and allocations per collision
+    static void PrintRun(std::ostream& os, std::uint64_t numCollisions);
+
+private:
+    G4int fWarmup;
+    G4int fCheckpointEvery;
+    G4int fEvents = 0;
+    AllocationTracker::Snapshot fEventStart{};
+    AllocationTracker::Snapshot fSteadyStart{};
+    AllocationTracker::Snapshot fLast{};
+    std::array<std::uint64_t, AllocationTracker::kNumPhases> fMaxAllocsPerEvent{};
+    std::vector<std::pair<G4double, G4double>> fLiveBytes;  // (event, live bytes)
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ANALYSIS_ACCEPTANCE_HH
+#define ANALYSIS_ACCEPTANCE_HH
+
+#include "G4PhysicalConstants.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Coarse phase space an analysis can ever fill, published through
+// HadronicAnalysis::GetAcceptance(). It must be a superset of what Fill()
+// accepts: the driver drops everything outside it before computing any
+// observables. The default accepts every secondary.
+struct AnalysisAcceptance {
+    std::vector<G4int> pdgCodes;          // empty: any particle
+    G4double maxThetaLab = CLHEP::pi;     // lab polar angle, internal units
+    G4double minMomentum = 0.;            // |p_lab|, internal units
+    G4double maxMomentum = -1.;           // < 0: no upper limit
+};
+
+// AnalysisAcceptance compiled into integer compares and squared-momentum
+// tests on the lab 3-momentum: no sqrt, no trigonometry, no boost.
+// Boundaries are inclusive so that the filter never rejects an edge value.
+class AcceptanceFilter {
+public:
+    explicit AcceptanceFilter(const AnalysisAcceptance& acceptance)
+        : fPdgCodes(acceptance.pdgCodes) {
+        std::sort(fPdgCodes.begin(), fPdgCodes.end());
+        fPdgCodes.erase(std::unique(fPdgCodes.begin(), fPdgCodes.end()), fPdgCodes.end());
+
+        fMinP2 = acceptance.minMomentum > 0. ? acceptance.minMomentum * acceptance.minMomentum : 0.;
+        fMaxP2 = acceptance.maxMomentum >= 0. ? acceptance.maxMomentum * acceptance.maxMomentum : -1.;
+        fCutTheta = acceptance.maxThetaLab < CLHEP::pi;
+        const G4double cosMax = std::cos(std::max(acceptance.maxThetaLab, 0.));
+        fForward = cosMax >= 0.;
+        fCos2Max = cosMax * cosMax;
+    }
+
+    /// False if the secondary can't enter the analysis
+    inline G4bool Accepts(G4int pdg, const G4ThreeVector& p) const {
+        if (!fPdgCodes.empty() && !AcceptsPdg(pdg)) return false;
+        const G4double p2 = p.mag2();
+        if (p2 < fMinP2 || (fMaxP2 >= 0. && p2 > fMaxP2)) return false;
+        if (fCutTheta) {
+            // theta <= thetaMax  <=>  pz >= cos(thetaMax) |p|
+            const G4double pz = p.z();
+            const G4double rhs = fCos2Max * p2;
+            if (fForward) return pz >= 0. && pz * pz >= rhs;
+            return pz >= 0. || pz * pz <= rhs;
+        }
+        return true;
+    }
+
+    G4bool AcceptsAll() const {
+        return fPdgCodes.empty() && fMinP2 == 0. && fMaxP2 < 0. && !fCutTheta;
+    }
+
+private:
+    inline G4bool AcceptsPdg(G4int pdg) const {
+        // The sets are a handful of codes: a linear scan beats a binary search
+        for (G4int code : fPdgCodes) {
+            if (code == pdg) return true;
+        }
+        return false;
+    }
+
+    std::vector<G4int> fPdgCodes;
+    G4double fMinP2 = 0.;
+    G4double fMaxP2 = -1.;
+    G4double fCos2Max = 1.;
+    G4bool fCutTheta = false;
+    G4bool fForward = true;
+};
+
+#endif
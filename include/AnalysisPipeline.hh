@@ -0,0 +1,124 @@
+#ifndef ANALYSIS_PIPELINE_HH
+#define ANALYSIS_PIPELINE_HH
+
+#include "HadronicAnalysis.hh"
+#include "HadronicGenerator.hh"
+#include "SpmcRing.hh"
+
+#include "G4LorentzVector.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Moves computeObservables and Fill off the generation thread. The generation
+// loop copies each collision's accepted secondaries (definition and lab
+// four-momentum), CMS frame and generator record into batches of a few
+// collisions, written in place into the slots of an SpmcRing. Analysis
+// threads, each with its own instance of the analysis, take whole batches,
+// compute the observables and fill; at Finish() the instances are merged into
+// the first one through their accumulators.
+//
+// The generation thread only waits when the ring is full, i.e. when the
+// analysis threads are a whole ring of batches behind; such stalls are counted
+// and reported, and are the cue for more analysis threads or a deeper ring.
+// Bootstrap weights depend on the collision index only, so every analysis
+// thread draws them itself and the results equal those of a serial run up to
+// the order of floating-point additions.
+class AnalysisPipeline {
+public:
+    struct Secondary {
+        const G4ParticleDefinition* definition;
+        G4LorentzVector p4;         // lab frame
+    };
+
+    struct Event {
+        G4int index;
+        HadronicEventRecord record;
+        G4ThreeVector cmsBoost;
+        G4double sqrtS;
+        std::uint32_t firstSecondary;
+        std::uint32_t numSecondaries;
+    };
+
+    struct Batch {
+        std::vector<Event> events;
+        std::vector<Secondary> secondaries;
+    };
+
+    /// `analyses[0]` receives the merged results; one analysis thread per
+    /// instance. `batchCollisions` collisions per batch, `depth` batches in flight.
+    AnalysisPipeline(const std::vector<HadronicAnalysis*>& analyses, std::size_t batchCollisions,
+                     std::size_t depth, G4int bootstrapReplicas, std::uint64_t bootstrapSeed);
+    ~AnalysisPipeline();
+
+    AnalysisPipeline(const AnalysisPipeline&) = delete;
+    AnalysisPipeline& operator=(const AnalysisPipeline&) = delete;
+
+    /// Generation thread, once per collision, then AddSecondary for each
+    /// accepted secondary, then EndEvent
+    inline void BeginEvent(G4int index, const HadronicEventRecord& record, const G4ThreeVector& cmsBoost,
+                           G4double sqrtS);
+    inline void AddSecondary(const G4ParticleDefinition* definition, const G4LorentzVector& p4);
+    inline void EndEvent();
+
+    /// Hand over the last batch, wait for the analysis threads and merge their
+    /// instances into analyses[0]; false if they cannot be merged
+    G4bool Finish();
+
+    void PrintStatistics(std::ostream& os) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void ClaimBatch();
+    void PublishBatch();
+    void Consume(std::size_t consumer);
+
+    std::vector<HadronicAnalysis*> fAnalyses;
+    std::size_t fBatchCollisions;
+    G4int fBootstrapReplicas;
+    std::uint64_t fBootstrapSeed;
+    SpmcRing<Batch> fRing;
+    std::vector<std::thread> fThreads;
+
+    // Generation thread
+    Batch* fBatch = nullptr;
+    std::uint64_t fBatches = 0;
+    std::uint64_t fStalls = 0;
+    Clock::duration fStallTime{};
+
+    // Per analysis thread
+    struct alignas(64) ConsumerCounters {
+        std::uint64_t batches = 0;
+        std::uint64_t secondaries = 0;
+        Clock::duration busy{};
+    };
+    std::vector<ConsumerCounters> fCounters;
+};
+
+inline void AnalysisPipeline::BeginEvent(G4int index, const HadronicEventRecord& record,
+                                         const G4ThreeVector& cmsBoost, G4double sqrtS)
+{
+    if (fBatch == nullptr) ClaimBatch();
+    const auto first = static_cast<std::uint32_t>(fBatch->secondaries.size());
+    fBatch->events.push_back({index, record, cmsBoost, sqrtS, first, 0});
+}
+
+inline void AnalysisPipeline::AddSecondary(const G4ParticleDefinition* definition, const G4LorentzVector& p4)
+{
+    fBatch->secondaries.push_back({definition, p4});
+    ++fBatch->events.back().numSecondaries;
+}
+
+inline void AnalysisPipeline::EndEvent()
+{
+    if (fBatch->events.size() >= fBatchCollisions) PublishBatch();
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef ANALYSIS_REGISTRY_HH
+#define ANALYSIS_REGISTRY_HH
+
+#include <map>
+#include <string>
+#include <vector>
+
+class HadronicAnalysis;
+
+// Registry of analyses compiled directly into the executable
+// (CMake option WITH_STATIC_ANALYSES). Analyses register themselves during
+// static initialisation through DECLARE_HADRONIC_ANALYSIS, and Create() has
+// the same semantics as the CreateAnalysis() entry point of a plugin.
+class AnalysisRegistry {
+public:
+    using Factory = HadronicAnalysis* (*)();
+
+    static AnalysisRegistry& Instance();
+
+    /// Returns true so that it can initialise a namespace-scope constant
+    bool Register(const std::string& name, Factory factory);
+
+    /// New instance of the named analysis, or nullptr if it is not compiled in
+    HadronicAnalysis* Create(const std::string& name) const;
+
+    std::vector<std::string> Names() const;
+
+private:
+    std::map<std::string, Factory> fFactories;
+};
+
+#endif
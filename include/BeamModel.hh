@@ -0,0 +1,114 @@
+#ifndef BEAM_MODEL_HH
+#define BEAM_MODEL_HH
+
+#include "TargetModel.hh"
+
+#include "CLHEP/Random/MixMaxRng.h"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+class G4ParticleDefinition;
+
+// Beam phase space: nominal momentum along +z with an optional Gaussian or
+// tabulated momentum spread and Gaussian angular divergence, or momenta
+// replayed from a beam file. Projectile kinematics are generated in blocks of
+// kBlockSize events, stored as structure-of-arrays, together with the CMS boost
+// and sqrt(s) of each block event on every nucleus of the target; the per-event
+// cost is an index increment. The model owns its random engine, so the beam is
+// reproducible independently of what the hadronic models draw.
+class BeamModel {
+public:
+    static constexpr std::size_t kBlockSize = 1024;
+
+    BeamModel(G4ParticleDefinition* projectile, G4double momentum);
+
+    /// Gaussian sigma(p)/p
+    void SetMomentumSpread(G4double relativeSigma) { fRelativeSpread = relativeSigma; }
+    /// Gaussian sigma of the projected angles theta_x and theta_y
+    void SetDivergence(G4double sigmaAngle) { fDivergence = sigmaAngle; }
+    void SetSeed(long seed) { fEngine.setSeed(seed); }
+    /// Start at beam particle `event` of the run, for a worker that takes a
+    /// later range of it: a replayed beam file resumes at that row. Call before
+    /// the first Next(); sampled beams only need their own seed.
+    void SetFirstEvent(std::size_t event) {
+        if (!fBeamFile.empty()) fBeamFileNext = event % fBeamFile.size();
+    }
+
+    /// Read "p weight" rows (GeV/c; histogram with lower bin edges p, the last
+    /// row closing the range) as momentum spectrum, or "px py pz" rows (GeV/c)
+    /// as beam particles replayed in order. '#' starts a comment.
+    G4bool LoadBeamFile(const std::string& fileName);
+
+    /// Nuclei for which boosts are precomputed; call before the first Next()
+    void SetTarget(const TargetModel& target);
+
+    G4bool IsPencil() const;
+    G4double GetNominalMomentum() const { return fMomentum; }
+    G4ParticleDefinition* GetProjectile() const { return fProjectile; }
+
+    /// Slot of the next beam particle in the current block
+    inline std::size_t Next();
+
+    inline G4ThreeVector Momentum(std::size_t slot) const;
+    G4double KineticEnergy(std::size_t slot) const { return fEnergy[slot] - fMass; }
+    /// CMS frame of beam particle `slot` on `nucleus`
+    inline void CmsFrame(std::size_t slot, const TargetModel::Nucleus& nucleus,
+                         G4ThreeVector& boost, G4double& sqrtS) const;
+
+private:
+    void FillBlock();
+    void SampleMomenta();
+    void ComputeFrames();
+
+    G4ParticleDefinition* fProjectile;
+    G4double fMass;
+    G4double fMomentum;
+    G4double fRelativeSpread = 0.;
+    G4double fDivergence = 0.;
+    std::vector<G4double> fSpectrumEdges;   // tabulated |p| spectrum
+    std::vector<G4double> fSpectrumCdf;
+    std::vector<G4ThreeVector> fBeamFile;   // replayed momenta
+    std::size_t fBeamFileNext = 0;
+    CLHEP::MixMaxRng fEngine;
+
+    std::vector<G4double> fTargetMasses;
+    std::size_t fNext = kBlockSize;
+
+    // Block, structure-of-arrays
+    std::vector<G4double> fPx, fPy, fPz, fEnergy;
+    std::vector<G4double> fBx, fBy, fBz, fSqrtS;  // [nucleus * kBlockSize + slot]
+    std::vector<G4double> fRandom;
+};
+
+inline std::size_t BeamModel::Next()
+{
+    if (fNext == kBlockSize) FillBlock();
+    return fNext++;
+}
+
+inline G4ThreeVector BeamModel::Momentum(std::size_t slot) const
+{
+    return G4ThreeVector(fPx[slot], fPy[slot], fPz[slot]);
+}
+
+inline void BeamModel::CmsFrame(std::size_t slot, const TargetModel::Nucleus& nucleus,
+                                G4ThreeVector& boost, G4double& sqrtS) const
+{
+    if (nucleus.index < fTargetMasses.size()) {
+        const std::size_t k = nucleus.index * kBlockSize + slot;
+        boost.set(fBx[k], fBy[k], fBz[k]);
+        sqrtS = fSqrtS[k];
+        return;
+    }
+    // Nucleus that was not in the material definition: computed on the spot
+    const G4double e = fEnergy[slot] + nucleus.mass;
+    boost.set(fPx[slot] / e, fPy[slot] / e, fPz[slot] / e);
+    const G4double p2 = fPx[slot] * fPx[slot] + fPy[slot] * fPy[slot] + fPz[slot] * fPz[slot];
+    sqrtS = std::sqrt(e * e - p2);
+}
+
+#endif
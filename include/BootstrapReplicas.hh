@@ -0,0 +1,186 @@
+// BootstrapReplicas.hh
+// In-run Poisson bootstrap. Every collision gets K integer weights drawn from
+// Poisson(1), all derived from one 64-bit draw per event (BootstrapWeights);
+// every secondary of that collision is then filled into the K replicas of its
+// bin with those weights (BootstrapReplicas). The spread of the replicas
+// estimates the statistical uncertainty, including the correlations between
+// bins that share collisions, without rerunning the job K times.
+//
+//   driver:    weights.Draw(event); analysis->BeginEvent({event, weights.Get()});
+//   analysis:  replicas.Fill(flatBin, event.bootstrapWeights);
+//   Finalize:  writeBootstrap(GetName(), histos, replicas);
+#pragma once
+#include <YODA/Estimate.h>
+#include <YODA/Histo.h>
+#include <YODA/WriterYODA.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+/// K Poisson(1) weights per collision
+class BootstrapWeights {
+public:
+    BootstrapWeights(int numReplicas, std::uint64_t seed)
+        : fSeed(seed), fWeights(numReplicas, 1) {
+        // Thresholds on a 32-bit uniform: w = number of thresholds <= u
+        double p = std::exp(-1.);
+        double cdf = p;
+        for (int j = 0; j < kMaxWeight; ++j) {
+            fThresholds[j] = static_cast<std::uint32_t>(std::min(cdf * 4294967296., 4294967295.));
+            p /= (j + 1);
+            cdf += p;
+        }
+    }
+
+    /// Weights for collision `event`; depends only on the seed and the event
+    /// index, so it does not disturb any other random stream
+    void Draw(std::uint64_t event) {
+        // Scramble (seed, event) into the starting point, so that the streams
+        // of neighbouring events don't overlap
+        std::uint64_t state = event;
+        state = SplitMix64(state) ^ fSeed;
+        state = SplitMix64(state);
+        const std::size_t n = fWeights.size();
+        for (std::size_t k = 0; k < n; k += 2) {
+            const std::uint64_t bits = SplitMix64(state);
+            fWeights[k] = Poisson(static_cast<std::uint32_t>(bits));
+            if (k + 1 < n) fWeights[k + 1] = Poisson(static_cast<std::uint32_t>(bits >> 32));
+        }
+    }
+
+    const std::uint8_t* Get() const { return fWeights.data(); }
+    int Size() const { return static_cast<int>(fWeights.size()); }
+
+private:
+    static constexpr int kMaxWeight = 12;  // P(w > 12) ~ 1e-10
+
+    static std::uint64_t SplitMix64(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    inline std::uint8_t Poisson(std::uint32_t u) const {
+        std::uint8_t w = 0;
+        for (int j = 0; j < kMaxWeight; ++j) w += (u >= fThresholds[j]);
+        return w;
+    }
+
+    std::uint64_t fSeed;
+    std::vector<std::uint8_t> fWeights;
+    std::uint32_t fThresholds[kMaxWeight];
+};
+
+/// Replica sums of weights for a flat set of bins, K per bin
+class BootstrapReplicas {
+public:
+    void Book(std::size_t numBins, int numReplicas) {
+        fNumReplicas = numReplicas;
+        fSums.assign(numBins * numReplicas, 0.);
+    }
+
+    bool Enabled() const { return fNumReplicas > 0; }
+    int NumReplicas() const { return fNumReplicas; }
+    std::size_t NumBins() const { return fNumReplicas > 0 ? fSums.size() / fNumReplicas : 0; }
+
+    /// Add weight w of one secondary in `bin` to every replica
+    inline void Fill(std::size_t bin, const std::uint8_t* weights, double w = 1.0) {
+        double* sums = &fSums[bin * fNumReplicas];
+        for (int k = 0; k < fNumReplicas; ++k) sums[k] += w * weights[k];
+    }
+
+    double Mean(std::size_t bin) const {
+        const double* sums = &fSums[bin * fNumReplicas];
+        double mean = 0.;
+        for (int k = 0; k < fNumReplicas; ++k) mean += sums[k];
+        return mean / fNumReplicas;
+    }
+
+    double Covariance(std::size_t i, std::size_t j) const {
+        if (fNumReplicas < 2) return 0.;
+        const double mi = Mean(i);
+        const double mj = Mean(j);
+        const double* a = &fSums[i * fNumReplicas];
+        const double* b = &fSums[j * fNumReplicas];
+        double cov = 0.;
+        for (int k = 0; k < fNumReplicas; ++k) cov += (a[k] - mi) * (b[k] - mj);
+        return cov / (fNumReplicas - 1);
+    }
+
+    double Error(std::size_t bin) const { return std::sqrt(Covariance(bin, bin)); }
+
+    /// Replica sums, [bin * K + replica]
+    double* Data() { return fSums.data(); }
+    std::size_t DataSize() const { return fSums.size(); }
+
+private:
+    int fNumReplicas = 0;
+    std::vector<double> fSums;  // [bin * K + replica]
+};
+
+/// Files written by writeBootstrap(base, ...)
+inline std::vector<std::string> bootstrapFiles(const std::string& base) {
+    return {base + "_bootstrap.yoda", base + "_bootstrap_cov.txt"};
+}
+
+/// Write <base>_bootstrap.yoda, one Estimate1D per histogram with the nominal
+/// sum of weights per unit x and a "bootstrap" error, and <base>_bootstrap_cov.txt
+/// with the covariance of all bins. Values, errors and covariance are divided by
+/// the bin widths, like Histo1D::mkEstimate(), so they compare directly with
+/// reference Estimate1Ds. Replica bins are the visible bins of `histos`
+/// concatenated in order. `scales`, if given, holds the factor each histogram
+/// was scaled by after filling (e.g. a cross-section normalisation), which the
+/// replica sums did not see.
+inline void writeBootstrap(const std::string& base, const std::vector<YODA::Histo1D*>& histos,
+                           const BootstrapReplicas& replicas, const std::vector<double>& scales = {}) {
+    struct BinLabel {
+        std::string path;
+        double xLow, xHigh;
+    };
+    std::vector<BinLabel> labels;
+    std::vector<double> binScale;
+    std::vector<YODA::AnalysisObject*> out;
+    std::size_t flat = 0;
+    for (std::size_t k = 0; k < histos.size(); ++k) {
+        const auto* h = histos[k];
+        const double scale = k < scales.size() ? scales[k] : 1.;
+        const std::vector<double> edges = h->xEdges();
+        auto* est = new YODA::Estimate1D(edges);
+        est->setPath(h->path());
+        for (const auto& key : h->annotations()) est->addAnnotation(key, h->annotation(key));
+        est->addAnnotation("BootstrapReplicas", std::to_string(replicas.NumReplicas()));
+        for (std::size_t i = 0; i + 1 < edges.size(); ++i, ++flat) {
+            const double width = edges[i + 1] - edges[i];
+            const double err = scale / width * replicas.Error(flat);
+            auto& bin = est->bin(i + 1);
+            bin.setVal(h->bin(i + 1).sumW() / width);
+            bin.setErr({-err, err}, "bootstrap");
+            labels.push_back({h->path(), edges[i], edges[i + 1]});
+            binScale.push_back(scale / width);
+        }
+        out.push_back(est);
+    }
+    YODA::WriterYODA::create().write(base + "_bootstrap.yoda", out);
+    for (auto* ao : out) delete ao;
+
+    std::ofstream cov(base + "_bootstrap_cov.txt");
+    cov << "# Bootstrap covariance of the bin contents per unit x, " << replicas.NumReplicas()
+        << " replicas, " << labels.size() << " bins\n";
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        cov << "# " << i << " " << labels[i].path << " [" << labels[i].xLow << ", "
+            << labels[i].xHigh << ")\n";
+    }
+    cov << std::setprecision(8);
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        for (std::size_t j = 0; j < labels.size(); ++j) {
+            cov << (j ? " " : "") << binScale[i] * binScale[j] * replicas.Covariance(i, j);
+        }
+        cov << "\n";
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef CHI2_MONITOR_HH
+#define CHI2_MONITOR_HH
+
+#include "HadronicAnalysis.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <vector>
+
+// Compares a running analysis to its reference data every `interval`
+// collisions and tells the event loop to stop once the run cannot end up
+// compatible with the data, so that model-parameter scans spend their CPU on
+// candidates that still can.
+//
+// With data d +- s and a prediction m +- e (statistical) from n of the run's N
+// collisions,
+//
+//   chi2  = sum (m - d)^2 / (s^2 + e^2)
+//   lower = sum max(0, |m - d| - k e)^2 / (s^2 + e^2 n / N)
+//
+// `lower` bounds the chi2 at the end of the run as long as every final
+// prediction lies within k standard deviations of the current one, and as
+// the statistical errors shrink like 1/sqrt(n). A run is aborted once lower/ndf
+// exceeds the threshold. Only the accumulators are read, so a check costs
+// one pass over the reference bins.
+class Chi2Monitor {
+public:
+    struct Summary {
+        std::size_t numPoints = 0;
+        G4double chi2 = 0.;
+        G4double chi2Lower = 0.;
+        G4double maxPull = 0.;   // largest |m - d| / sqrt(s^2 + e^2)
+    };
+
+    Chi2Monitor(G4double threshold, std::int64_t interval, std::int64_t totalCollisions,
+                G4double numSigma = 3.);
+
+    /// False if the analysis has nothing to compare to
+    G4bool IsEnabled(const HadronicAnalysis& analysis) const;
+
+    /// Per-event hook after `collisions` of the run's collisions; true if the
+    /// run should be aborted
+    inline G4bool Poll(const HadronicAnalysis& analysis, std::int64_t collisions);
+
+    /// Compare now and report to `os`; true if the run should be aborted
+    G4bool Check(const HadronicAnalysis& analysis, std::int64_t collisions, std::ostream& os);
+
+    Summary Compare(const std::vector<ReferencePoint>& points, std::int64_t collisions) const;
+
+    const Summary& GetLast() const { return fLast; }
+
+private:
+    G4double fThreshold;
+    std::int64_t fInterval;
+    std::int64_t fTotal;
+    G4double fNumSigma;
+    std::int64_t fNext;
+    Summary fLast;
+};
+
+inline G4bool Chi2Monitor::Poll(const HadronicAnalysis& analysis, std::int64_t collisions)
+{
+    if (collisions < fNext) return false;
+    return Check(analysis, collisions, std::cout);
+}
+
+#endif
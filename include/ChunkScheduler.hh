@@ -0,0 +1,90 @@
+#ifndef CHUNK_SCHEDULER_HH
+#define CHUNK_SCHEDULER_HH
+
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Runs the collisions of several configurations on a pool of worker threads.
+// Configurations are cut into chunks of consecutive collisions. Every worker
+// owns a deque: it takes chunks from the back of its own deque and, when that
+// is empty, steals from the front of the others'; only when all deques are
+// empty does it carve new chunks from the configurations still pending.
+//
+// The cost of a collision can differ by an order of magnitude between
+// configurations, so chunks are sized in time rather than in collisions. Each
+// configuration first runs a short probe chunk; afterwards its measured cost
+// per collision converts a target chunk duration into a number of collisions.
+// The target is a fraction of the estimated remaining work per worker, so
+// chunks shrink as the matrix drains, and the configuration with the most
+// remaining work is carved first. Together this keeps the idle tail at the
+// end of the run to about one short chunk.
+class ChunkScheduler {
+public:
+    struct Chunk {
+        std::size_t config = 0;
+        std::int64_t first = 0;   // first collision index within the configuration
+        std::int64_t count = 0;
+    };
+
+    using WorkerFunction = std::function<void(std::size_t worker)>;
+    using ChunkFunction = std::function<void(std::size_t worker, const Chunk& chunk)>;
+
+    ChunkScheduler(const std::vector<std::int64_t>& collisionsPerConfig, std::size_t numWorkers);
+
+    /// Start the workers and block until every collision has been run.
+    /// `init` is called once on each worker thread before its first chunk;
+    /// `poll`, if set, is called periodically on the calling thread meanwhile.
+    void Run(const WorkerFunction& init, const ChunkFunction& run,
+             const std::function<void()>& poll = nullptr);
+
+    std::size_t GetNumWorkers() const { return fWorkers.size(); }
+
+    /// Per-configuration cost, per-worker load and the idle tail of the last Run
+    void PrintStatistics(std::ostream& os) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        std::int64_t total = 0;
+        std::int64_t next = 0;           // first collision not yet carved into a chunk
+        std::int64_t measured = 0;       // collisions in completed chunks
+        G4double seconds = 0.;           // time spent in completed chunks
+        std::uint64_t chunks = 0;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+        G4double busy = 0.;
+        std::uint64_t chunksRun = 0;
+        std::uint64_t stolen = 0;
+        Clock::time_point finished;
+    };
+
+    void WorkerLoop(std::size_t worker, const WorkerFunction& init, const ChunkFunction& run);
+    G4bool PopOwn(std::size_t worker, Chunk& chunk);
+    G4bool Steal(std::size_t worker, Chunk& chunk);
+    G4bool Carve(std::size_t worker, Chunk& chunk);
+    void Complete(const Chunk& chunk, G4double seconds);
+    /// Seconds per collision of `config`; unmeasured configurations are
+    /// assumed to be as expensive as the most expensive measured one
+    G4double Cost(const Config& config) const;
+
+    std::vector<Config> fConfigs;
+    std::vector<Worker> fWorkers;
+    std::mutex fMutex;                   // fConfigs
+    std::atomic<std::size_t> fRunning{0};
+    Clock::time_point fStart;
+    Clock::time_point fEnd;
+};
+
+#endif
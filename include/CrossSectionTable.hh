@@ -0,0 +1,67 @@
+#ifndef CROSS_SECTION_TABLE_HH
+#define CROSS_SECTION_TABLE_HH
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class G4Material;
+class G4ParticleDefinition;
+class HadronicGenerator;
+
+// Inelastic cross sections per target atom, sigma_inel = sum_e n_e sigma_e / n,
+// on a fixed logarithmic momentum grid for each (projectile, material) pair,
+// taken from the cross-section datasets the generator registered with the
+// projectile's inelastic process.
+//
+// Grids are kept in a cache file, one per physics case and Geant4 version,
+// which is mapped read-only: a run whose pairs are all cached makes no Geant4
+// cross-section call at all. Missing pairs are evaluated once and the file is
+// rewritten (to a temporary name, then renamed, so that concurrent jobs never
+// read a partial cache). Lookups interpolate linearly in log(p).
+class CrossSectionTable {
+public:
+    static constexpr G4int kNumPoints = 241;   // 40 per decade
+    static constexpr G4double kLogPMin = -1.;  // log10(p / GeV)
+    static constexpr G4double kLogPMax = 5.;
+
+    /// An empty `cacheFile` selects xsec_<physics>_g4<version>.cache in the working directory
+    CrossSectionTable(const std::string& physics, const std::string& cacheFile = "");
+    ~CrossSectionTable();
+
+    CrossSectionTable(const CrossSectionTable&) = delete;
+    CrossSectionTable& operator=(const CrossSectionTable&) = delete;
+
+    /// Make grids available for all pairs, evaluating the ones not cached with
+    /// `generator`, which must be of this table's physics case. Not thread-safe:
+    /// call it before any worker starts.
+    void Require(HadronicGenerator& generator,
+                 const std::vector<std::pair<G4ParticleDefinition*, G4Material*>>& pairs);
+
+    /// sigma_inel per target atom at `momentum`; 0 for a pair not Require()d
+    G4double Inelastic(const G4ParticleDefinition* projectile, const G4Material* material,
+                       G4double momentum) const;
+
+    const std::string& GetCacheFile() const { return fCacheFile; }
+
+private:
+    using Key = std::pair<std::string, std::string>;  // projectile, material
+
+    void Load();
+    G4bool Write() const;
+    static std::vector<G4double> Evaluate(HadronicGenerator& generator, G4ParticleDefinition* projectile,
+                                          G4Material* material);
+
+    std::string fPhysics;
+    std::string fCacheFile;
+    void* fMapping = nullptr;
+    std::size_t fMappingSize = 0;
+    std::map<Key, const G4double*> fGrids;            // into the mapping or fEvaluated
+    std::map<Key, std::vector<G4double>> fEvaluated;  // this run's additions
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef EVENT_JOURNAL_HH
+#define EVENT_JOURNAL_HH
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <string>
+
+// Binary journal of a run: a fixed header with the run configuration, then one
+// record per collision holding the seed the Geant4 engine was set to before
+// GenerateInteraction, the beam momentum, and the outcome. Any collision can
+// then be regenerated on its own (ThinTargetSim --replay-event k) instead of
+// rerunning everything before it.
+//
+// The file is pre-sized and written through a shared memory mapping: a record
+// costs a few stores and no system call, and what was written survives a crash
+// of the process. A collision that crashed has numSecondaries == -1.
+struct JournalHeader {
+    char magic[8];              // "TTSJRNL1"
+    std::uint32_t headerSize;
+    std::uint32_t recordSize;
+    std::int64_t runSeed;
+    std::int64_t numCollisions;
+    std::int32_t g4Version;
+    std::int32_t reserved;
+    G4double thickness;         // internal units
+    char physics[32];
+    char projectile[32];
+    char material[32];
+};
+
+struct JournalRecord {
+    std::uint64_t seed;
+    G4double px, py, pz;            // beam momentum, internal units
+    std::int32_t numSecondaries;    // -1 while (or if) the collision is being generated
+    std::int32_t nucleus;           // 1000 * Z + A of the struck nucleus, 0 if none
+    std::int64_t nanoseconds;
+};
+
+class EventJournal {
+public:
+    /// Seed of collision `event`: a hash of the run seed and the event index
+    static std::uint64_t EventSeed(std::int64_t runSeed, std::int64_t event);
+
+    ~EventJournal();
+
+    /// Create `fileName` for header.numCollisions records
+    G4bool Create(const std::string& fileName, const JournalHeader& header);
+    /// Map an existing journal read-only
+    G4bool Open(const std::string& fileName);
+
+    const JournalHeader& Header() const { return *fHeader; }
+    std::int64_t NumRecords() const { return fHeader->numCollisions; }
+    const JournalRecord& Record(std::int64_t event) const { return fRecords[event]; }
+
+    /// Called before GenerateInteraction
+    inline void Begin(std::int64_t event, std::uint64_t seed, const G4ThreeVector& momentum);
+    /// Called once the collision is complete
+    inline void End(std::int64_t event, G4int numSecondaries, G4int nucleus, std::int64_t ns);
+
+    static JournalHeader MakeHeader(std::int64_t runSeed, std::int64_t numCollisions,
+                                    const std::string& physics, const std::string& projectile,
+                                    const std::string& material, G4double thickness);
+
+private:
+    G4bool Map(int fd, std::size_t size, G4bool writable);
+
+    void* fMapping = nullptr;
+    std::size_t fSize = 0;
+    JournalHeader* fHeader = nullptr;
+    JournalRecord* fRecords = nullptr;
+};
+
+inline void EventJournal::Begin(std::int64_t event, std::uint64_t seed, const G4ThreeVector& momentum)
+{
+    JournalRecord& r = fRecords[event];
+    r.seed = seed;
+    r.px = momentum.x();
+    r.py = momentum.y();
+    r.pz = momentum.z();
+    r.numSecondaries = -1;
+}
+
+inline void EventJournal::End(std::int64_t event, G4int numSecondaries, G4int nucleus,
+                              std::int64_t ns)
+{
+    JournalRecord& r = fRecords[event];
+    r.numSecondaries = numSecondaries;
+    r.nucleus = nucleus;
+    r.nanoseconds = ns;
+}
+
+#endif
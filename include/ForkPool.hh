@@ -0,0 +1,46 @@
+#ifndef FORK_POOL_HH
+#define FORK_POOL_HH
+
+#include "globals.hh"
+
+#include <sys/types.h>
+#include <vector>
+
+// Worker processes forked from a fully initialised parent. Everything built
+// before Start() (particle tables, materials, generators with their cross
+// section tables, booked analyses) is shared copy-on-write, so the workers
+// skip the startup and only pages they write to are duplicated.
+//
+// Each worker sends its results to the parent as a sequence of double arrays
+// through its own pipe and ends with Exit(); the parent reads them in the same
+// order with Receive() and collects the exit codes with Wait().
+class ForkPool {
+public:
+    explicit ForkPool(std::size_t numWorkers) : fNumWorkers(numWorkers) {}
+
+    /// Fork the workers. Returns the worker index in a worker and -1 in the
+    /// parent; -2 in the parent if a fork failed (the workers started are
+    /// stopped).
+    G4int Start();
+
+    std::size_t GetNumWorkers() const { return fNumWorkers; }
+
+    /// Worker: send one array to the parent
+    G4bool Send(const G4double* data, std::size_t size);
+    /// Worker: flush and leave without running the parent's exit handlers and
+    /// destructors, which own nothing the worker may release
+    [[noreturn]] void Exit(G4bool ok);
+
+    /// Parent: next array sent by `worker`
+    G4bool Receive(std::size_t worker, std::vector<G4double>& data);
+    /// Parent: wait for every worker; false if any did not exit cleanly
+    G4bool Wait();
+
+private:
+    std::size_t fNumWorkers;
+    std::vector<pid_t> fPids;
+    std::vector<int> fPipes;  // read ends in the parent
+    int fPipe = -1;           // write end in a worker
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef GENERIC_YODA_ANALYSIS_HH
+#define GENERIC_YODA_ANALYSIS_HH
+
+#include "BootstrapReplicas.hh"
+#include "HadronicAnalysis.hh"
+#include "HistogramAccumulator.hh"
+
+#include <string>
+#include <vector>
+
+// Built-in analysis driven entirely by a reference YODA file: every
+// Estimate1D carrying the "Secondary" and "Theta range" annotations is booked
+// as a histogram with the same edges and annotations. The optional "Variable"
+// annotation selects what is histogrammed (p, pt, T, xF, y, theta; default p,
+// momenta/energies in GeV, theta in mrad).
+// All booked objects are compiled into one selector, grouped by PDG code and
+// sorted by theta, and filled in a single pass per secondary into one
+// HistogramAccumulator holding sumW and sumW2 per bin; the Histo1D objects only
+// exist while Finalize writes them.
+// Selected with `-a path/to/reference.yoda`; results go to <name>_MC.yoda.
+class GenericYodaAnalysis final : public HadronicAnalysis {
+public:
+    explicit GenericYodaAnalysis(const std::string& referenceFile);
+
+    void Initialize(G4int numCollisions) override;
+    void BeginEvent(const EventInfo& event) override;
+    void Fill(const Observables& obs, const G4ParticleDefinition* pd) override;
+    AnalysisAcceptance GetAcceptance() const override;
+    std::vector<AccumulatorBlock> Accumulators() override;
+    void Finalize() override;
+    std::string GetName() const override;
+    std::vector<std::string> GetOutputFiles() const override;
+    std::vector<std::string> GetInputFiles() const override { return {fReferenceFile}; }
+
+    enum Variable : int { kMomentum = 0, kPt, kKineticEnergy, kXF, kRapidity, kTheta, kNumVariables };
+
+private:
+    struct SliceSelector {
+        double thetaMin;  // mrad
+        double thetaMax;  // mrad
+        Variable variable;
+        std::size_t object;  // in fHistos
+    };
+
+    struct SpeciesSelector {
+        int pdg;
+        std::vector<SliceSelector> slices;  // sorted by thetaMin
+    };
+
+    static Variable ParseVariable(const std::string& name);
+    static double Value(Variable variable, const Observables& obs);
+    inline void FillObject(std::size_t object, double x);
+
+    std::string fReferenceFile;
+    std::string fName;
+    G4int fNumCollisions = 0;
+    HistogramAccumulator fHistos{HistogramAccumulator::kWeights};
+    std::vector<SpeciesSelector> fSpecies;
+    BootstrapReplicas fReplicas;   // same bin order as fHistos
+    const std::uint8_t* fBootstrapWeights = nullptr;
+};
+
+#endif
@@ -5,29 +5,114 @@
 #include "G4ParticleDefinition.hh"
 #include "G4LorentzVector.hh"
 
+#include "AnalysisAcceptance.hh"
 #include "Observables.hh"
+#include "RunInfo.hh"
 
 #include <string>
+#include <vector>
+
+// A contiguous array of additive analysis state (sums of weights, moments,
+// bootstrap replica sums). Instances of an analysis that saw disjoint sets of
+// collisions of the same configuration combine by element-wise addition.
+struct AccumulatorBlock {
+    double* data;
+    std::size_t size;
+};
+
+// A point of the reference measurement next to the prediction of the
+// collisions filled so far, in the units of the reference
+struct ReferencePoint {
+    double data;
+    double dataError;
+    double mc;
+    double mcVariance;   // statistical, of the collisions so far
+};
 
 // Abstract base class for analyses (like Rivet::Analysis)
 class HadronicAnalysis {
 public:
     virtual ~HadronicAnalysis() {}
 
+    /// Run configuration; set by the driver before Initialize
+    void SetRunInfo(const RunInfo& info) { fRunInfo = info; }
+    const RunInfo& GetRunInfo() const { return fRunInfo; }
+
     /// Called once at the beginning of the run
     virtual void Initialize(G4int numCollisions) = 0;
 
+    /// Called at the start of every collision, before its secondaries are filled
+    virtual void BeginEvent(const EventInfo& /*event*/) {}
+
     /// Called for every secondary particle
     virtual void Fill(const Observables& obs, const G4ParticleDefinition* pd) = 0;
 
+    /// Coarse phase space Fill can ever accept; queried once after Initialize.
+    /// Secondaries outside it are dropped before their observables are computed.
+    virtual AnalysisAcceptance GetAcceptance() const { return {}; }
+
+    /// Additive state, in a fixed order after Initialize. Empty if the analysis
+    /// cannot be merged, in which case a run cannot be split across workers.
+    virtual std::vector<AccumulatorBlock> Accumulators() { return {}; }
+
+    /// Reference points and the predictions of the first `numCollisions`
+    /// collisions, for comparing a run to data while it goes on. Empty if the
+    /// analysis has no reference or its results are not comparable before Finalize.
+    virtual std::vector<ReferencePoint> CompareToReference(G4int /*numCollisions*/) const { return {}; }
+
     /// Called once at the end of the run
     virtual void Finalize() = 0;
 
     /// Return name of the analysis
     virtual std::string GetName() const = 0;
+
+    /// Base name of output files: GetName(), plus "_<tag>" with an output tag
+    std::string GetOutputName() const {
+        return fRunInfo.outputTag.empty() ? GetName() : GetName() + "_" + fRunInfo.outputTag;
+    }
+
+    /// Files Finalize writes, for the result cache; a run of an analysis that
+    /// names none is not cached
+    virtual std::vector<std::string> GetOutputFiles() const { return {}; }
+
+    /// Files Initialize reads (reference data, binnings); their contents are
+    /// part of the result-cache key
+    virtual std::vector<std::string> GetInputFiles() const { return {}; }
+
+protected:
+    RunInfo fRunInfo;
 };
 
+// Add the accumulators of `from` into those of `into`; false if the analysis
+// has none or the two instances were booked differently
+inline bool mergeAccumulators(HadronicAnalysis& into, HadronicAnalysis& from) {
+    const std::vector<AccumulatorBlock> a = into.Accumulators();
+    const std::vector<AccumulatorBlock> b = from.Accumulators();
+    if (a.empty() || a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].size != b[i].size) return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        for (std::size_t k = 0; k < a[i].size; ++k) a[i].data[k] += b[i].data[k];
+    }
+    return true;
+}
+
 // Factory function signature used by plugins
 extern "C" HadronicAnalysis* CreateAnalysis();
 
+// Put once in each analysis source file. Plugin builds export CreateAnalysis();
+// with WITH_STATIC_ANALYSES the analysis registers itself in AnalysisRegistry
+// instead, so that several analyses can be linked into one executable.
+#ifdef THINTARGET_STATIC_ANALYSES
+#include "AnalysisRegistry.hh"
+#define DECLARE_HADRONIC_ANALYSIS(CLASS)                                            \
+    static HadronicAnalysis* Create_##CLASS() { return new CLASS(); }               \
+    static const bool CLASS##_registered =                                          \
+        AnalysisRegistry::Instance().Register(#CLASS, &Create_##CLASS);
+#else
+#define DECLARE_HADRONIC_ANALYSIS(CLASS)                                            \
+    extern "C" HadronicAnalysis* CreateAnalysis() { return new CLASS(); }
+#endif
+
 #endif
@@ -5,6 +5,12 @@
 #include "HadronicAnalysis.hh"
 
 HadronicAnalysis* LoadAnalysis(const std::string& libPath, void** handleOut);
+// GenericYodaAnalysis for a name ending in ".yoda", else the statically
+// registered analysis if available, else lib<name>.so from LD_LIBRARY_PATH
+// or ./plugins. *handleOut is nullptr unless a plugin was loaded.
+HadronicAnalysis* LoadAnalysisByName(const std::string& name, void** handleOut);
 void UnloadAnalysis(HadronicAnalysis* analysis, void* handle);
+// File the plugin behind `handle` was loaded from; empty for a nullptr handle
+std::string AnalysisLibraryPath(void* handle);
 
 #endif
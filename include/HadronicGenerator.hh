@@ -67,13 +67,16 @@
 #define HadronicGenerator_h 1
 
 #include "G4HadronicProcess.hh"
+#include "G4SystemOfUnits.hh"
 #include "G4ThreeVector.hh"
 #include "G4ios.hh"
 #include "globals.hh"
 
 #include <iomanip>
 #include <map>
+#include <vector>
 
+class G4FTFModel;
 class G4ParticleDefinition;
 class G4VParticleChange;
 class G4ParticleTable;
@@ -82,6 +85,24 @@ class G4HadronicInteraction;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+struct HadronicEventRecord
+{
+    // Summary of the last "GenerateInteraction" call, filled as part of it.
+    // The impact parameter, spectator and NN-collision numbers are only
+    // available when the FTF model handled the collision; otherwise they keep
+    // the negative defaults (-999) of the corresponding getters.
+    const G4HadronicInteraction* model = nullptr;  // nullptr: no collision
+    G4int targetZ = 0;
+    G4int targetA = 0;
+    G4bool handledByFTF = false;
+    G4double impactParameter = -999.0 * CLHEP::fermi;
+    G4int numProjectileSpectatorNucleons = -999;
+    G4int numTargetSpectatorNucleons = -999;
+    G4int numNNcollisions = -999;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 class HadronicGenerator
 {
     // This class provides the functionality of a "hadronic generator"
@@ -147,6 +168,17 @@ class HadronicGenerator
     // Returns the hadronic process and the hadronic interaction, respectively,
     // that handled the last call of "GenerateInteraction".
 
+    inline const HadronicEventRecord& GetEventRecord() const;
+    // Returns the summary of the last call of "GenerateInteraction": the model
+    // that handled it, the struck target nucleus and, for FTF, the impact
+    // parameter, spectator nucleons and NN collisions. Reading it costs nothing:
+    // it is filled with a few pointer comparisons and plain getters per event.
+
+    G4HadronicProcess* FindHadronicProcess(G4ParticleDefinition* projectileDefinition) const;
+    // Returns the inelastic hadronic process that "GenerateInteraction" uses for
+    // the specified projectile (nullptr if there is none), e.g. to evaluate
+    // cross sections before generating any collision.
+
     G4double GetImpactParameter() const;
     G4int GetNumberOfTargetSpectatorNucleons() const;
     G4int GetNumberOfProjectileSpectatorNucleons() const;
@@ -154,14 +186,20 @@ class HadronicGenerator
     // In the case of hadronic interactions handled by the FTF model, returns,
     // respectively, the impact parameter, the number of target/projectile
     // spectator nucleons, and the number of nucleon-nucleon collisions,
-    // else, returns a negative value (-999).
+    // else, returns a negative value (-999). Same as the fields of GetEventRecord().
 
   private:
+    void FillEventRecord();
+
     G4String fPhysicsCase;
     G4bool fPhysicsCaseIsSupported;
     G4HadronicProcess* fLastHadronicProcess;
     G4ParticleTable* fPartTable;
     std::map<G4ParticleDefinition*, G4HadronicProcess*> fProcessMap;
+    const G4FTFModel* fFTFModel;
+    // The "FTFP" G4TheoFSGenerator instances, all driving fFTFModel
+    std::vector<const G4HadronicInteraction*> fFTFPModels;
+    HadronicEventRecord fEventRecord;
 };
 
 inline G4bool HadronicGenerator::IsPhysicsCaseSupported() const
@@ -179,6 +217,11 @@ inline G4HadronicInteraction* HadronicGenerator::GetHadronicInteraction() const
   return fLastHadronicProcess == nullptr ? nullptr : fLastHadronicProcess->GetHadronicInteraction();
 }
 
+inline const HadronicEventRecord& HadronicGenerator::GetEventRecord() const
+{
+  return fEventRecord;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 #endif
@@ -0,0 +1,92 @@
+#ifndef HEPMC_WRITER_HH
+#define HEPMC_WRITER_HH
+
+#include "globals.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One collision as exported: plain numbers only, so that the generation
+// thread does nothing but copy and the formatting happens on the writer thread
+struct ExportedParticle {
+    G4int pdg;
+    G4double px, py, pz, e, m;  // internal units
+};
+
+struct ExportedEvent {
+    std::int64_t number = 0;
+    ExportedParticle beam{};
+    ExportedParticle target{};
+    std::string model;
+    G4double impactParameter = -1.;     // < 0: not available
+    G4int numNNcollisions = -1;
+    G4int projectileSpectators = -1;
+    G4int targetSpectators = -1;
+    std::vector<ExportedParticle> secondaries;
+};
+
+// Streams collisions to a HepMC3 ASCII (Asciiv3) file from a dedicated thread.
+// The generation thread fills a slot of a bounded ring of preallocated events
+// (Acquire/Publish) and returns immediately; it only waits if the writer is a
+// whole ring behind, which is counted and reported. A file name ending in
+// ".gz" is written gzip-compressed when built WITH_ZLIB.
+//
+// Each event has a single vertex with the beam particle and the target nucleus
+// (status 4) as incoming and the secondaries (status 1) as outgoing particles,
+// momenta in GeV. The model name, impact parameter [fm], number of NN
+// collisions and spectator counts are event attributes when available.
+// Collisions without secondaries are written too; if no nucleus was sampled
+// the target has PDG code 0 and the model attribute is "none".
+class HepMCWriter {
+public:
+    explicit HepMCWriter(const std::string& fileName, std::size_t capacity = 256);
+    ~HepMCWriter();
+
+    G4bool IsOpen() const { return fOpen; }
+
+    /// Next free slot; cleared of the previous content except capacities
+    ExportedEvent& Acquire();
+    /// Hand the slot returned by Acquire() to the writer thread
+    void Publish();
+
+    /// Drain the queue, write the footer and join the writer thread
+    void Close();
+
+    void PrintStatistics(std::ostream& os) const;
+
+private:
+    void Run();
+    void Format(const ExportedEvent& event, std::string& out) const;
+    G4bool WriteRaw(const std::string& text);
+
+    std::string fFileName;
+    G4bool fOpen = false;
+    G4bool fCompressed = false;
+    std::FILE* fFile = nullptr;
+    void* fGzFile = nullptr;
+
+    std::vector<ExportedEvent> fSlots;
+    std::size_t fHead = 0;   // next slot to write
+    std::size_t fTail = 0;   // next slot to fill
+    std::size_t fCount = 0;  // published, not yet written
+    G4bool fClosing = false;
+    std::mutex fMutex;
+    std::condition_variable fNotEmpty;
+    std::condition_variable fNotFull;
+    std::thread fThread;
+
+    std::uint64_t fWritten = 0;
+    std::uint64_t fBytes = 0;
+    std::uint64_t fStalls = 0;
+    std::chrono::steady_clock::duration fStallTime{};
+    G4bool fWriteError = false;
+};
+
+#endif
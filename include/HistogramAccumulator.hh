@@ -0,0 +1,140 @@
+// HistogramAccumulator.hh
+// Flat fill target for many 1D histograms booked from reference Estimate1D
+// objects. All bins of all booked objects live back to back in one array,
+// `stride` doubles per bin:
+//
+//   kWeights: sumW, sumW2
+//   kMoments: numEntries, sumW, sumW2, sumWX, sumWX2   (the full Dbn1D)
+//
+// and all edges in a second one, so a fill touches two contiguous arrays
+// instead of a heap-allocated YODA::Histo1D with its bin objects. Path and
+// annotations are kept aside and only used by ToHisto() at Finalize or merge
+// time. With kWeights the Dbn1D of a bin is rebuilt with the effective number
+// of entries and the bin centre as mean.
+//
+//   Initialize:  std::size_t h = acc.Book(*estimate);
+//   Fill:        const int bin = acc.Fill(h, x);
+//   Finalize:    YODA::Histo1D* histo = acc.ToHisto(h);   // caller owns it
+#pragma once
+#include "HistogramUtils.hh"
+
+#include <YODA/Estimate.h>
+#include <YODA/Histo.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class HistogramAccumulator {
+public:
+    enum Layout : std::size_t { kWeights = 2, kMoments = 5 };
+
+    explicit HistogramAccumulator(Layout layout = kMoments) : fStride(layout) {}
+
+    /// Book an object with the binning, path and annotations of `reference`;
+    /// returns its index
+    std::size_t Book(const YODA::Estimate1D& reference) {
+        std::vector<std::pair<std::string, std::string>> annotations;
+        for (const auto& key : reference.annotations()) annotations.emplace_back(key, reference.annotation(key));
+        return Book(reference.path(), reference.xEdges(), std::move(annotations));
+    }
+
+    std::size_t Book(const std::string& path, const std::vector<double>& edges,
+                     std::vector<std::pair<std::string, std::string>> annotations = {}) {
+        if (edges.size() < 2 || !std::is_sorted(edges.begin(), edges.end())) {
+            throw std::invalid_argument("HistogramAccumulator: invalid binning for " + path);
+        }
+        Object object;
+        object.path = path;
+        object.annotations = std::move(annotations);
+        object.firstEdge = fEdges.size();
+        object.numBins = edges.size() - 1;
+        object.firstBin = fNumBins;
+        fEdges.insert(fEdges.end(), edges.begin(), edges.end());
+        fNumBins += object.numBins;
+        fData.resize(fNumBins * fStride, 0.);
+        fObjects.push_back(std::move(object));
+        return fObjects.size() - 1;
+    }
+
+    /// Fill x with weight w; returns the flat bin (see FirstBin) or -1 outside the range
+    inline int Fill(std::size_t object, double x, double w = 1.0) {
+        const Object& o = fObjects[object];
+        const double* edges = &fEdges[o.firstEdge];
+        if (!(x >= edges[0] && x < edges[o.numBins])) return -1;
+        const std::size_t bin =
+            o.firstBin + (std::upper_bound(edges, edges + o.numBins + 1, x) - edges - 1);
+        double* m = &fData[bin * fStride];
+        if (fStride == kMoments) {
+            m[0] += 1.;
+            m[1] += w;
+            m[2] += w * w;
+            m[3] += w * x;
+            m[4] += w * x * x;
+        }
+        else {
+            m[0] += w;
+            m[1] += w * w;
+        }
+        return static_cast<int>(bin);
+    }
+
+    /// Annotated histogram of `object`, weights multiplied by `scale`; the caller owns it
+    YODA::Histo1D* ToHisto(std::size_t object, double scale = 1.) const {
+        const Object& o = fObjects.at(object);
+        const std::vector<double> edges = Edges(object);
+        auto* histo = new YODA::Histo1D(edges);
+        for (const auto& [key, value] : o.annotations) histo->addAnnotation(key, value);
+        histo->setPath(o.path);
+        for (std::size_t i = 0; i < o.numBins; ++i) {
+            const double* m = &fData[(o.firstBin + i) * fStride];
+            if (fStride == kMoments) {
+                histoSetBin(*histo, i, m[0], m[1], m[2], m[3], m[4]);
+                continue;
+            }
+            const double centre = 0.5 * (edges[i] + edges[i + 1]);
+            const double numEntries = m[1] > 0. ? m[0] * m[0] / m[1] : 0.;
+            histoSetBin(*histo, i, numEntries, m[0], m[1], m[0] * centre, m[0] * centre * centre);
+        }
+        if (scale != 1.) histo->scaleW(scale);
+        return histo;
+    }
+
+    std::size_t NumObjects() const { return fObjects.size(); }
+    std::size_t NumBins() const { return fNumBins; }
+    std::size_t NumBins(std::size_t object) const { return fObjects.at(object).numBins; }
+    /// Offset of the object's bins in the flat bin numbering, e.g. for bootstrap replicas
+    std::size_t FirstBin(std::size_t object) const { return fObjects.at(object).firstBin; }
+    const std::string& Path(std::size_t object) const { return fObjects.at(object).path; }
+    std::vector<double> Edges(std::size_t object) const {
+        const Object& o = fObjects.at(object);
+        return {fEdges.begin() + o.firstEdge, fEdges.begin() + o.firstEdge + o.numBins + 1};
+    }
+    double XMin(std::size_t object) const { return fEdges[fObjects.at(object).firstEdge]; }
+    double XMax(std::size_t object) const {
+        const Object& o = fObjects.at(object);
+        return fEdges[o.firstEdge + o.numBins];
+    }
+
+    /// All bin contents as one flat array, for merging accumulators booked alike
+    double* Data() { return fData.data(); }
+    std::size_t DataSize() const { return fData.size(); }
+
+private:
+    struct Object {
+        std::string path;
+        std::vector<std::pair<std::string, std::string>> annotations;
+        std::size_t firstEdge = 0;  // in fEdges
+        std::size_t numBins = 0;
+        std::size_t firstBin = 0;   // in fData, in bins
+    };
+
+    std::size_t fStride;
+    std::size_t fNumBins = 0;
+    std::vector<double> fData;
+    std::vector<double> fEdges;
+    std::vector<Object> fObjects;
+};
@@ -0,0 +1,202 @@
+// HistogramSelection.hh
+// Compile-time selection and binning for "PDG code x theta slice x momentum"
+// analyses. Cuts are declared as types and constexpr edge arrays, e.g.
+//
+//   inline constexpr std::array<double, 5> kPiEdges{0.2, 0.4, 1.0, 2.0, 4.0};  // GeV/c
+//   using PiPlus = Selection::Species<211, Selection::ThetaSlice<0, 20, kPiEdges>,
+//                                          Selection::ThetaSlice<20, 40, kPiEdges>>;
+//   using PiMinus = Selection::Species<-211, Selection::ThetaSlice<0, 20, kPiEdges>>;
+//   using Cuts = Selection::SpeciesSet<PiPlus, PiMinus>;
+//   Selection::Accumulator<Cuts> acc;
+//   acc.Fill(pdg, theta_mrad, p_GeV);     // one flat index, no heap objects
+//   acc.Export("/MyAnalysis", histos);    // one YODA::Histo1D per slice
+//
+// Everything the fill needs is a compile-time constant: the species test
+// folds to a few integer compares, the slice search runs over constexpr
+// theta edges, and the momentum bin is found by a branchless binary search
+// whose trip count is fixed by the edge count.
+#pragma once
+#include "HistogramUtils.hh"
+
+#include <YODA/Histo.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Selection {
+
+/// Index of the bin [edges[i], edges[i+1]) containing x, or -1 outside the range
+template <std::size_t N>
+constexpr int findBin(const std::array<double, N>& edges, double x) {
+    static_assert(N >= 2, "need at least one bin");
+    if (!(x >= edges[0] && x < edges[N - 1])) return -1;
+    // Branchless lower bound: the loop runs ceil(log2(N)) times for every x
+    const double* base = edges.data();
+    std::size_t n = N;
+    while (n > 1) {
+        const std::size_t half = n / 2;
+        base = (base[half] <= x) ? base + half : base;
+        n -= half;
+    }
+    return static_cast<int>(base - edges.data());
+}
+
+/// Run-time description of one booked slice, in flat bin order
+struct SliceInfo {
+    int pdg;
+    double thetaMin;             // mrad
+    double thetaMax;             // mrad
+    std::vector<double> edges;   // momentum, GeV/c
+    std::size_t firstBin;        // flat index of its first momentum bin
+
+    std::size_t NumBins() const { return edges.size() - 1; }
+    /// "lo-hi mrad", the form of the "Theta range" annotation
+    std::string Label() const {
+        return std::to_string(static_cast<int>(thetaMin)) + "-"
+               + std::to_string(static_cast<int>(thetaMax)) + " mrad";
+    }
+};
+
+/// Theta slice [LoMrad, HiMrad) with its own momentum edges
+template <int LoMrad, int HiMrad, const auto& MomentumEdges>
+struct ThetaSlice {
+    static_assert(LoMrad < HiMrad, "empty theta slice");
+    static constexpr double kThetaMin = LoMrad;
+    static constexpr double kThetaMax = HiMrad;
+    static constexpr const auto& kEdges = MomentumEdges;
+    static constexpr std::size_t kNumBins = MomentumEdges.size() - 1;
+    static constexpr double kMomentumMin = MomentumEdges.front();
+    static constexpr double kMomentumMax = MomentumEdges.back();
+};
+
+/// All theta slices booked for one PDG code
+template <int Pdg, class... Slices>
+struct Species {
+    static constexpr int kPdg = Pdg;
+    static constexpr std::size_t kNumSlices = sizeof...(Slices);
+    static constexpr std::size_t kNumBins = (Slices::kNumBins + ... + 0);
+    static constexpr double kThetaMax = std::max({Slices::kThetaMax...});
+    static constexpr double kMomentumMin = std::min({Slices::kMomentumMin...});
+    static constexpr double kMomentumMax = std::max({Slices::kMomentumMax...});
+
+    /// Bin index local to this species, or -1
+    static constexpr int Locate(double thetaMrad, double p) {
+        int offset = 0;
+        int result = -1;
+        // Slices are tested in declaration order and the first match wins,
+        // which is what the hand-written analyses do with their `break`.
+        ((result == -1 && thetaMrad >= Slices::kThetaMin && thetaMrad < Slices::kThetaMax
+              ? (result = Locate1<Slices>(p, offset))
+              : 0,
+          offset += static_cast<int>(Slices::kNumBins)),
+         ...);
+        return result < 0 ? -1 : result;
+    }
+
+    static void AppendSlices(std::vector<SliceInfo>& out, std::size_t offset) {
+        ((out.push_back({kPdg, Slices::kThetaMin, Slices::kThetaMax,
+                         {Slices::kEdges.begin(), Slices::kEdges.end()}, offset}),
+          offset += Slices::kNumBins),
+         ...);
+    }
+
+private:
+    template <class Slice>
+    static constexpr int Locate1(double p, int offset) {
+        const int bin = findBin(Slice::kEdges, p);
+        // A secondary inside the slice but outside its momentum range is
+        // dropped, not passed on to a later slice
+        return bin < 0 ? -2 : offset + bin;
+    }
+};
+
+/// Union of species: maps (pdg, theta, p) to one flat bin index
+template <class... Specs>
+struct SpeciesSet {
+    static constexpr std::size_t kNumBins = (Specs::kNumBins + ... + 0);
+    static constexpr std::array<int, sizeof...(Specs)> kPdgCodes{Specs::kPdg...};
+    static constexpr double kThetaMax = std::max({Specs::kThetaMax...});
+    static constexpr double kMomentumMin = std::min({Specs::kMomentumMin...});
+    static constexpr double kMomentumMax = std::max({Specs::kMomentumMax...});
+
+    static constexpr bool Accepts(int pdg) { return ((pdg == Specs::kPdg) || ...); }
+
+    /// Flat bin index in [0, kNumBins), or -1
+    static constexpr int Locate(int pdg, double thetaMrad, double p) {
+        int offset = 0;
+        int result = -1;
+        ((pdg == Specs::kPdg && result < 0 ? (result = Adjust(Specs::Locate(thetaMrad, p), offset))
+                                           : 0,
+          offset += static_cast<int>(Specs::kNumBins)),
+         ...);
+        return result;
+    }
+
+    /// Every slice, species in declaration order, then their slices
+    static std::vector<SliceInfo> Slices() {
+        std::vector<SliceInfo> out;
+        std::size_t offset = 0;
+        ((Specs::AppendSlices(out, offset), offset += Specs::kNumBins), ...);
+        return out;
+    }
+
+private:
+    static constexpr int Adjust(int local, int offset) { return local < 0 ? -1 : offset + local; }
+};
+
+/// Flat YODA::Dbn1D-compatible moments for every bin of a SpeciesSet
+template <class Sel>
+class Accumulator {
+public:
+    using Moments = std::array<double, 5>;  // numEntries, sumW, sumW2, sumWX, sumWX2
+
+    /// x is the histogrammed variable (the momentum in GeV/c). Returns the
+    /// flat bin that was filled, for per-bin side data, or -1
+    inline int Fill(int pdg, double thetaMrad, double x, double w = 1.0) {
+        if (!Sel::Accepts(pdg)) return -1;
+        const int bin = Sel::Locate(pdg, thetaMrad, x);
+        if (bin < 0) return -1;
+        double* m = fMoments[bin].data();
+        m[0] += 1.;
+        m[1] += w;
+        m[2] += w * w;
+        m[3] += w * x;
+        m[4] += w * x * x;
+        return bin;
+    }
+
+    const Moments& operator[](std::size_t bin) const { return fMoments[bin]; }
+
+    /// All moments as one flat array, for merging accumulators of the same Sel
+    double* Data() { return fMoments.front().data(); }
+    static constexpr std::size_t DataSize() { return Sel::kNumBins * std::tuple_size<Moments>::value; }
+
+    /// Fill h, booked with the edges of slice, from the moments of that slice
+    void SetBins(const SliceInfo& slice, YODA::Histo1D& h) const {
+        for (std::size_t i = 0; i < slice.NumBins(); ++i) {
+            const Moments& m = fMoments[slice.firstBin + i];
+            histoSetBin(h, i, m[0], m[1], m[2], m[3], m[4]);
+        }
+    }
+
+    /// Append one annotated Histo1D per slice, named <prefix>/<pdg>/theta_<lo>_<hi>mrad
+    void Export(const std::string& prefix, std::vector<YODA::AnalysisObject*>& out) const {
+        for (const SliceInfo& slice : Sel::Slices()) {
+            auto* h = new YODA::Histo1D(slice.edges);
+            h->setPath(prefix + "/" + std::to_string(slice.pdg) + "/theta_"
+                       + std::to_string(static_cast<int>(slice.thetaMin)) + "_"
+                       + std::to_string(static_cast<int>(slice.thetaMax)) + "mrad");
+            h->addAnnotation("Theta range", slice.Label());
+            SetBins(slice, *h);
+            out.push_back(h);
+        }
+    }
+
+private:
+    std::array<Moments, Sel::kNumBins> fMoments{};
+};
+
+}  // namespace Selection
@@ -36,6 +36,13 @@ inline void histoInit(const std::vector<YODA::AnalysisObject*>& aovec,
     throw std::runtime_error("No matching AO found for histogram: " + name);
 }
 
+// Set visible bin i (0-based) of h from accumulated Dbn1D moments
+inline void histoSetBin(YODA::Histo1D& h, std::size_t i, double numEntries, double sumW,
+                        double sumW2, double sumWX, double sumWX2) {
+    // Global bin 0 is the underflow
+    h.set(i + 1, YODA::Dbn1D(numEntries, sumW, sumW2, sumWX, sumWX2));
+}
+
 inline std::pair<double, double> parseThetaRange(const std::string& s) {
     std::regex re(R"((\d+(?:\.\d+)?)[\s\-]+(\d+(?:\.\d+)?)\s*mrad)");
     std::smatch match;
@@ -52,7 +59,15 @@ inline int pdgFromName(const std::string& name) {
     if (name == "pi+") return 211;
     if (name == "pi-") return -211;
     if (name == "proton") return 2212;
-    if (name == "kaon_") return 321;
+    if (name == "kaon+" || name == "kaon_") return 321;
     if (name == "kaon-") return -321;
+    if (name == "anti_proton") return -2212;
+    if (name == "neutron") return 2112;
+    if (name == "kaon0S") return 310;
+    if (name == "lambda") return 3122;
+    // Plain PDG codes are accepted as well
+    if (!name.empty() && name.find_first_not_of("+-0123456789") == std::string::npos) {
+        return std::stoi(name);
+    }
     throw std::runtime_error("Unknown secondary particle name: " + name);
 }
@@ -0,0 +1,85 @@
+#ifndef LIVE_SNAPSHOT_HH
+#define LIVE_SNAPSHOT_HH
+
+#include "HadronicAnalysis.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Layout of a live snapshot segment: this header, then numBlocks block sizes
+// (std::uint64_t), then the numValues accumulator values (double) of all blocks.
+// Everything after `sequence` is written under a seqlock: the sequence number
+// is odd while a snapshot is being copied in, and a reader's copy is
+// consistent if it saw the same even number before and after it.
+struct LiveSnapshotHeader {
+    char magic[8];                          // "TTSLIVE1"
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t numBlocks;
+    std::uint64_t numValues;
+    std::int64_t collisions;                // run by this process at the snapshot
+    std::int64_t totalCollisions;           // of this process
+    G4double inelasticXS;                   // RunInfo::inelasticXS
+    std::int32_t bootstrapReplicas;
+    std::int32_t pid;
+    G4double unixTime;                      // of the snapshot
+    char analysis[256];                     // as given to -a
+    char outputTag[64];
+};
+
+// Publishes the accumulators of a running analysis into a POSIX shared-memory
+// segment (/dev/shm/<name>), so that partial results can be looked at with
+// ThinTargetLive while the run goes on. The event loop calls Poll() after
+// every collision; once per interval it copies the accumulators into the
+// segment under a seqlock. The writer never waits for readers: a reader that
+// raced with a copy simply retries. No file is written and the loop is not
+// paused beyond the copy itself. The segment is removed at destruction.
+class LiveSnapshot {
+public:
+    LiveSnapshot(const std::string& name, G4double intervalSeconds);
+    ~LiveSnapshot();
+
+    LiveSnapshot(const LiveSnapshot&) = delete;
+    LiveSnapshot& operator=(const LiveSnapshot&) = delete;
+
+    /// Create the segment for the accumulators of `analysis`, which must stay
+    /// booked as they are; `analysisName` is what ThinTargetLive will load
+    G4bool Open(HadronicAnalysis& analysis, const std::string& analysisName, std::int64_t totalCollisions);
+
+    /// Per-event hook: publish if the interval has elapsed
+    inline void Poll(std::int64_t collisions);
+
+    /// Copy the accumulators into the segment now
+    void Publish(std::int64_t collisions);
+
+    const std::string& GetName() const { return fName; }
+
+    /// Consistent copy of segment `name`: header fields, block sizes and values;
+    /// false if it does not exist, is not a snapshot, or stays busy
+    static G4bool Read(const std::string& name, LiveSnapshotHeader& header,
+                       std::vector<std::uint64_t>& blockSizes, std::vector<G4double>& values);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string fName;
+    Clock::duration fInterval;
+    Clock::time_point fNext;
+    std::vector<AccumulatorBlock> fBlocks;
+    void* fMapping = nullptr;
+    std::size_t fSize = 0;
+    LiveSnapshotHeader* fHeader = nullptr;
+    G4double* fValues = nullptr;
+};
+
+inline void LiveSnapshot::Poll(std::int64_t collisions)
+{
+    // One clock read per collision is noise next to the collision itself
+    if (fHeader == nullptr || Clock::now() < fNext) return;
+    Publish(collisions);
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MODEL_TIMING_PROFILER_HH
+#define MODEL_TIMING_PROFILER_HH
+
+#include "globals.hh"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class G4HadronicInteraction;
+
+// Optional per-model instrumentation of HadronicGenerator::GenerateInteraction.
+// Each event is attributed to the model returned by GetHadronicInteraction()
+// and its wall time and secondary multiplicity are accumulated into fixed-size
+// histograms, so recording never allocates once a model has been seen.
+class ModelTimingProfiler {
+public:
+    /// Record one GenerateInteraction call handled by `model` (may be null)
+    void Record(const G4HadronicInteraction* model, G4double kineticEnergy,
+                std::int64_t nanoseconds, G4int numSecondaries);
+
+    /// Print latency percentiles, multiplicities and cost per energy bin
+    void Dump(std::ostream& os) const;
+
+private:
+    // Latency buckets: log2 of the time in ns, each octave split in kSubBuckets
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kLatencyBuckets = 64 * kSubBuckets;
+    static constexpr int kMaxMultiplicity = 256;  // last bin is overflow
+    // Projectile kinetic energy: 4 bins per decade from 10 MeV to 100 TeV
+    static constexpr int kEnergyBinsPerDecade = 4;
+    static constexpr int kEnergyBins = 7 * kEnergyBinsPerDecade;
+
+    struct ModelStats {
+        const G4HadronicInteraction* model = nullptr;
+        std::string name;
+        std::uint64_t events = 0;
+        std::uint64_t secondaries = 0;
+        std::int64_t totalNs = 0;
+        std::int64_t maxNs = 0;
+        G4double minEnergy = 0.;
+        G4double maxEnergy = 0.;
+        std::array<std::uint64_t, kLatencyBuckets> latency{};
+        std::array<std::uint64_t, kMaxMultiplicity + 1> multiplicity{};
+        std::array<std::uint64_t, kEnergyBins> energyEvents{};
+        std::array<std::int64_t, kEnergyBins> energyNs{};
+    };
+
+    ModelStats& StatsFor(const G4HadronicInteraction* model);
+    static int LatencyBucket(std::int64_t ns);
+    static G4double LatencyBucketUpperEdge(int bucket);
+    static int EnergyBin(G4double kineticEnergy);
+    static G4double Percentile(const ModelStats& stats, G4double fraction);
+
+    std::vector<ModelStats> fStats;
+    std::size_t fLast = 0;
+};
+
+#endif
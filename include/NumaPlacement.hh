@@ -0,0 +1,69 @@
+#ifndef NUMA_PLACEMENT_HH
+#define NUMA_PLACEMENT_HH
+
+#include "globals.hh"
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Pins worker threads to the CPUs of the NUMA nodes of this machine, as read
+// from /sys/devices/system/node and restricted to the CPUs the process may run
+// on (sched_getaffinity), so that everything a worker allocates and
+// first touches after Pin() (its generators, analysis instances with their
+// reference binnings and accumulators, target tables) lands on the worker's
+// own node under the kernel's default first-touch policy. Nothing is bound
+// explicitly and no NUMA library is needed.
+//
+//   compact  fill the CPUs of node 0 first, then node 1, ...
+//   spread   deal workers round-robin over the nodes
+//
+// `maxNodes` restricts the placement to the first nodes, e.g. 1 to run on one
+// socket of a dual-socket machine. Workers record where their data ended up
+// (NodeOf) for the placement report.
+class NumaPlacement {
+public:
+    enum Policy { kCompact, kSpread };
+
+    NumaPlacement(Policy policy, std::size_t maxNodes = 0);
+
+    /// "compact" or "spread"; false for anything else
+    static G4bool ParsePolicy(const std::string& name, Policy& policy);
+
+    std::size_t NumNodes() const { return fNodes.size(); }
+
+    /// Pin the calling thread as worker `worker`; false, leaving the thread
+    /// unpinned, if the affinity could not be set or there is no usable CPU
+    G4bool Pin(std::size_t worker);
+
+    /// Note, for the report, the node of the memory at `address`, owned by `worker`
+    void Record(std::size_t worker, const std::string& what, const void* address);
+
+    /// NUMA node of the page holding `address`, -1 if unknown or not yet touched
+    static G4int NodeOf(const void* address);
+
+    /// CPU and node of every worker and the nodes of the memory it recorded
+    void PrintReport(std::ostream& os) const;
+
+private:
+    struct Node {
+        G4int id;
+        std::vector<G4int> cpus;
+    };
+
+    struct Worker {
+        G4int cpu = -1;
+        G4int node = -1;
+        G4bool pinned = false;
+        std::vector<std::pair<std::string, G4int>> memory;
+    };
+
+    Policy fPolicy;
+    std::vector<Node> fNodes;
+    std::vector<Worker> fWorkers;
+    mutable std::mutex fMutex;     // fWorkers
+};
+
+#endif
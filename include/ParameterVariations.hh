@@ -0,0 +1,71 @@
+#ifndef PARAMETER_VARIATIONS_HH
+#define PARAMETER_VARIATIONS_HH
+
+#include "globals.hh"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// One model-parameter variation: its tag, appended to the analysis output
+// names, and the parameters it sets
+struct ParameterVariation {
+    std::string tag;
+    std::vector<std::pair<std::string, G4double>> parameters;
+};
+
+// Read parameter variations, one per line:
+//
+//   tag [name=value ...]
+//
+// '#' starts a comment; a line with a tag only is the nominal setting. A name
+// is either a transition energy of G4HadronicParameters, in GeV:
+//
+//   MinEnergyTransitionFTF_Cascade  MaxEnergyTransitionFTF_Cascade
+//   MinEnergyTransitionQGS_FTF      MaxEnergyTransitionQGS_FTF
+//
+// or a G4HadronicDeveloperParameters name, e.g. the FTF_* parameters of the
+// FTF model. Tags must be unique. Returns an empty vector, after reporting the
+// line, on any error.
+std::vector<ParameterVariation> ReadParameterVariations(const std::string& fileName);
+
+// True if the variation sets a G4HadronicDeveloperParameters name, i.e. a
+// parameter that a model reads when it builds its own state, not only the
+// transition energies read when a generator is constructed
+G4bool SetsDeveloperParameters(const ParameterVariation& variation);
+
+// Sets the parameters of a variation for as long as it lives, i.e. while the
+// generator of the variation is built and warmed up; the previous values are
+// restored at destruction. Only state built inside that scope sees them: the
+// transition energies are read when the generator is constructed, and FTF
+// builds its G4FTFParameters at the first collision it handles, so the
+// warm-up runs until FTF has handled one. Model state built or rebuilt after
+// the scope reads the restored values.
+class ParameterOverride {
+public:
+    explicit ParameterOverride(const ParameterVariation& variation);
+    ~ParameterOverride();
+
+    ParameterOverride(const ParameterOverride&) = delete;
+    ParameterOverride& operator=(const ParameterOverride&) = delete;
+
+    /// False if a parameter is unknown or its value was refused
+    G4bool IsValid() const { return fValid; }
+
+private:
+    enum Kind { kTransition, kDouble, kInt, kBool };
+
+    struct Previous {
+        std::string name;
+        Kind kind;
+        G4double value;
+    };
+
+    /// False if the new value did not take
+    static G4bool Set(const std::string& name, Kind kind, G4double value);
+
+    std::vector<Previous> fPrevious;
+    G4bool fValid = true;
+};
+
+#endif
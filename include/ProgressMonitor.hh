@@ -0,0 +1,82 @@
+#ifndef PROGRESS_MONITOR_HH
+#define PROGRESS_MONITOR_HH
+
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Periodic progress and throughput reporting for long runs.
+// Workers only bump relaxed per-worker counters; the clock is read once every
+// fStride events, and RSS and the status file are touched only when a report is
+// due. The stride aims at ~10 clock reads per interval. It is set from the
+// slower of the instantaneous and average rates, grows at most twofold per
+// report and never beyond kMaxStride, and shrinks as soon as a clock read comes
+// late, so that a sudden slowdown (expensive collisions, a throttled node)
+// delays the next report by a bounded number of collisions.
+// Reports go to stderr and, optionally, to a JSON status file that is replaced
+// atomically so that a batch scheduler never reads a partial file.
+class ProgressMonitor {
+public:
+    ProgressMonitor(std::uint64_t totalCollisions, G4double intervalSeconds,
+                    const std::string& statusFile = "", std::size_t numWorkers = 1);
+
+    /// Account one collision with `numSecondaries` secondaries to `worker`
+    inline void Add(G4int numSecondaries, std::size_t worker = 0);
+
+    /// Cheap per-event hook for the driver thread: reads the clock only every fStride calls
+    inline void Poll();
+
+    /// Emit a report now if the interval has elapsed (safe to call from a monitor thread)
+    void ReportIfDue();
+
+    /// Emit the final report
+    void Finish();
+
+private:
+    struct alignas(64) WorkerCounters {
+        std::atomic<std::uint64_t> collisions{0};
+        std::atomic<std::uint64_t> secondaries{0};
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /// Clock read of Poll(): adapts the stride, then reports if due
+    void PollClock();
+    void Report(Clock::time_point now, G4bool final);
+    static G4double ResidentSetSizeMB();
+
+    std::uint64_t fTotal;
+    G4double fInterval;
+    std::string fStatusFile;
+    std::vector<WorkerCounters> fWorkers;
+
+    Clock::time_point fStart;
+    Clock::time_point fLastReport;
+    std::uint64_t fLastCollisions = 0;
+    std::uint64_t fLastSecondaries = 0;
+    std::vector<std::uint64_t> fLastWorkerCollisions;
+
+    static constexpr std::uint64_t kMaxStride = 1000;
+    Clock::time_point fLastPoll;
+    std::uint64_t fStride = 1;
+    std::uint64_t fCountdown = 1;
+};
+
+inline void ProgressMonitor::Add(G4int numSecondaries, std::size_t worker)
+{
+    fWorkers[worker].collisions.fetch_add(1, std::memory_order_relaxed);
+    fWorkers[worker].secondaries.fetch_add(numSecondaries, std::memory_order_relaxed);
+}
+
+inline void ProgressMonitor::Poll()
+{
+    if (--fCountdown > 0) return;
+    PollClock();
+    fCountdown = fStride;
+}
+
+#endif
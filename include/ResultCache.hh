@@ -0,0 +1,61 @@
+#ifndef RESULT_CACHE_HH
+#define RESULT_CACHE_HH
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Analysis results of earlier runs, addressed by their provenance: every input
+// that determines a result (configuration, seed, Geant4 version, the content of
+// the executable, the analysis library or reference file, a beam file) is added
+// as a "name = value" line, and the entry directory is named after a hash of
+// those lines. The number of collisions is not part of the key; the entry holds
+// one subdirectory per number of collisions run:
+//
+//   <directory>/<key>/provenance.txt
+//   <directory>/<key>/<N>/state.bin      additive state of the run
+//   <directory>/<key>/<N>/<outputs>      files written by Finalize
+//
+// A run for N collisions is then either a hit (entry N exists: its outputs are
+// copied back), a partial hit (the largest entry below N: its state is the
+// starting point for the collisions still missing), or a miss. Entries are
+// written to a temporary directory and renamed, so that concurrent jobs never
+// see a partial one; the stored provenance is compared in full on lookup.
+class ResultCache {
+public:
+    explicit ResultCache(const std::string& directory);
+
+    void Add(const std::string& name, const std::string& value);
+    void Add(const std::string& name, G4double value);
+    /// Add the content hash of file `path`; false if it cannot be read
+    G4bool AddFile(const std::string& name, const std::string& path);
+
+    /// Hex digest of the provenance added so far
+    std::string Key() const;
+
+    /// Largest number of collisions <= numCollisions with a stored entry, 0 if none
+    std::int64_t Lookup(std::int64_t numCollisions) const;
+
+    /// Copy the outputs of entry `numCollisions` to the working directory
+    G4bool Restore(std::int64_t numCollisions) const;
+
+    /// Arrays stored with entry `numCollisions`
+    G4bool LoadState(std::int64_t numCollisions, std::vector<std::vector<G4double>>& state) const;
+
+    /// Store `state` and copies of the `outputs` files as entry `numCollisions`
+    G4bool Store(std::int64_t numCollisions, const std::vector<std::vector<G4double>>& state,
+                 const std::vector<std::string>& outputs) const;
+
+private:
+    std::string EntryDirectory() const;
+    std::string RunDirectory(std::int64_t numCollisions) const;
+    /// The entry exists and was written for the same provenance
+    G4bool ProvenanceMatches() const;
+
+    std::string fDirectory;
+    std::string fProvenance;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef RUN_INFO_HH
+#define RUN_INFO_HH
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <string>
+
+struct HadronicEventRecord;
+
+// Run configuration handed to analyses before Initialize
+struct RunInfo {
+    G4int numCollisions = 0;
+    // sigma_inel per target atom for the nominal beam (internal units), so that
+    // Finalize can convert counts into cross sections; 0 if unknown
+    G4double inelasticXS = 0.;
+    G4int bootstrapReplicas = 0;   // K Poisson bootstrap replicas, 0: disabled
+    std::string outputTag;         // distinguishes the outputs of one run matrix row
+};
+
+// Per-collision information handed to HadronicAnalysis::BeginEvent
+struct EventInfo {
+    G4int index = 0;
+    // K Poisson(1) weights of this collision, one per replica; nullptr when
+    // bootstrapping is disabled
+    const std::uint8_t* bootstrapWeights = nullptr;
+    // Model, struck nucleus and FTF metadata of this collision; BeginEvent is
+    // called after the collision has been generated
+    const HadronicEventRecord* generator = nullptr;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RUN_MATRIX_HH
+#define RUN_MATRIX_HH
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One row of a run matrix: a complete single-run configuration
+struct RunConfiguration {
+    std::string physics;
+    std::string projectile;
+    G4double momentum = 0.;       // along +z, internal units
+    std::string material;
+    std::int64_t numCollisions = 0;
+    G4double thickness = 0.;      // internal units
+    std::string tag;              // appended to the analysis output names
+};
+
+// Read a run matrix, one configuration per line:
+//
+//   physics projectile p[GeV/c] material collisions [thickness[cm]] [tag]
+//
+// '#' starts a comment. Without a tag, one is made up from the other columns
+// (e.g. FTFP_proton_158GeV_G4_Pb); tags are made unique. Returns an empty
+// vector, after reporting the line, on any error.
+std::vector<RunConfiguration> ReadRunMatrix(const std::string& fileName);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SPMC_RING_HH
+#define SPMC_RING_HH
+
+#include "globals.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded lock-free ring of preallocated slots, one producer and any number of
+// consumers. Every slot carries a sequence number (Vyukov's bounded queue):
+//
+//   seq == pos             free for the producer at position pos
+//   seq == pos + 1         published, next for a consumer
+//   seq == pos + capacity  released by its consumer, free for the next lap
+//
+// The producer fills a slot in place (Claim/Publish) and consumers work on it
+// in place (Acquire/Release), so slot contents, e.g. vectors, keep their
+// capacity from lap to lap and nothing is allocated or copied in steady state.
+// A slot that is still being consumed is not reused: a full ring is the
+// back-pressure on the producer. Neither side ever takes a lock; waiting, if
+// any, is the caller's business.
+template <typename T>
+class SpmcRing {
+public:
+    /// `capacity` is rounded up to a power of two, at least 2: with a single
+    /// slot "published" (pos + 1) and "released" (pos + capacity) would be the
+    /// same sequence number, and the producer could reuse a slot in use
+    explicit SpmcRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        fSlots = std::vector<Slot>(size);
+        fMask = size - 1;
+        for (std::size_t i = 0; i < size; ++i) fSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    std::size_t Capacity() const { return fSlots.size(); }
+
+    /// Producer: the next slot to fill, nullptr if the ring is full
+    T* Claim() {
+        Slot& slot = fSlots[fTail & fMask];
+        if (slot.sequence.load(std::memory_order_acquire) != fTail) return nullptr;
+        return &slot.value;
+    }
+
+    /// Producer: hand the slot returned by Claim() to the consumers
+    void Publish() {
+        fSlots[fTail & fMask].sequence.store(fTail + 1, std::memory_order_release);
+        ++fTail;
+    }
+
+    /// Consumer: the oldest published slot, nullptr if there is none; pass
+    /// `ticket` to Release() when done with it
+    T* Acquire(std::uint64_t& ticket) {
+        std::uint64_t pos = fHead.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = fSlots[pos & fMask];
+            const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const std::int64_t diff = static_cast<std::int64_t>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (fHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ticket = pos;
+                    return &slot.value;
+                }
+            }
+            else if (diff < 0) {
+                return nullptr;
+            }
+            else {
+                pos = fHead.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Consumer: give the slot back to the producer
+    void Release(std::uint64_t ticket) {
+        fSlots[ticket & fMask].sequence.store(ticket + fSlots.size(), std::memory_order_release);
+    }
+
+    /// Producer: no more slots will be published
+    void Close() { fClosed.store(true, std::memory_order_release); }
+    G4bool IsClosed() const { return fClosed.load(std::memory_order_acquire); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> sequence{0};
+        T value;
+    };
+
+    std::vector<Slot> fSlots;
+    std::size_t fMask = 0;
+    alignas(64) std::uint64_t fTail = 0;             // producer only
+    alignas(64) std::atomic<std::uint64_t> fHead{0}; // shared by the consumers
+    std::atomic<G4bool> fClosed{false};
+};
+
+#endif
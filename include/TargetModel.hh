@@ -0,0 +1,94 @@
+#ifndef TARGET_MODEL_HH
+#define TARGET_MODEL_HH
+
+#include "G4HadronicProcess.hh"
+#include "G4LorentzVector.hh"
+#include "G4Nucleus.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+class G4Material;
+class G4ParticleDefinition;
+class HadronicGenerator;
+
+// Target description for one run configuration: every nucleus of a (possibly
+// compound or mixture) material with its mass and the sqrt(s) of the nominal
+// beam on it, plus the interaction probability of a target of finite thickness.
+// The thickness is informational: it enters that probability and the target
+// report only. Collisions are always generated in the thin-target limit, with
+// no beam attenuation or re-interaction weight applied to the histograms.
+// Geant4 samples the struck element and isotope inside GenerateInteraction;
+// StruckNucleus() maps that choice back onto the table, so the per-event cost
+// is one comparison against the previously struck nucleus. The per-event CMS
+// frame is then looked up by nucleus index in BeamModel.
+class TargetModel {
+public:
+    struct Nucleus {
+        std::size_t index = 0;    // position in GetNuclei()
+        G4int Z = 0;
+        G4int A = 0;
+        G4double mass = 0.;       // nuclear mass
+        G4double sqrtS = 0.;      // nominal beam
+        G4double expected = 0.;   // cross-section weighted fraction of interactions
+        std::uint64_t struck = 0;
+    };
+
+    /// thickness is only used for GetInteractionProbability() and Print();
+    /// 0 is the thin-target limit (interaction probability -> 0)
+    TargetModel(G4Material* material, G4double thickness);
+
+    /// Build the per-nucleus tables for this beam; cross sections are taken
+    /// from the generator's inelastic process for the projectile
+    void Prepare(HadronicGenerator& generator, G4ParticleDefinition* projectile,
+                 const G4ThreeVector& momentum);
+
+    /// Nucleus hit in the last GenerateInteraction handled by `process`.
+    /// The reference is valid until the next call.
+    inline const Nucleus& StruckNucleus(const G4HadronicProcess* process);
+
+    const std::vector<Nucleus>& GetNuclei() const { return fNuclei; }
+    G4Material* GetMaterial() const { return fMaterial; }
+    G4double GetThickness() const { return fThickness; }
+    /// Macroscopic inelastic cross section sum_i n_i sigma_i (1/length)
+    G4double GetMacroscopicCrossSection() const { return fSigmaMacro; }
+    /// 1 - exp(-thickness * Sigma), the fraction of beam particles interacting
+    G4double GetInteractionProbability() const;
+
+    /// Add the struck counts of a copy that sampled other collisions
+    void Merge(const TargetModel& other);
+    void AddStruck(G4int Z, G4int A, std::uint64_t count);
+
+    /// Target composition, expected and sampled fractions of struck nuclei
+    void Print(std::ostream& os) const;
+
+private:
+    const Nucleus& Lookup(G4int Z, G4int A);
+    Nucleus& Add(G4int Z, G4int A, G4double expected);
+
+    G4Material* fMaterial;
+    G4double fThickness;
+    G4double fSigmaMacro = 0.;
+    G4LorentzVector fBeam;
+    std::vector<Nucleus> fNuclei;
+    std::size_t fLast = 0;
+};
+
+inline const TargetModel::Nucleus& TargetModel::StruckNucleus(const G4HadronicProcess* process)
+{
+    const G4Nucleus* nucleus = process->GetTargetNucleus();
+    const G4int Z = nucleus->GetZ_asInt();
+    const G4int A = nucleus->GetA_asInt();
+    // Consecutive events mostly hit the same nucleus: try the last one first
+    Nucleus& last = fNuclei[fLast];
+    if (last.Z == Z && last.A == A) {
+        ++last.struck;
+        return last;
+    }
+    return Lookup(Z, A);
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include "AllocationTracker.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+#ifdef THINTARGET_ALLOC_TRACKING
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+// The phase is per thread, the counters are per process, so that the analysis
+// threads of --pipeline and the --matrix workers are accounted as well. Both
+// are constant-initialised (a plain int, atomics with constexpr constructors),
+// so they are safe to touch from operator new before static initialisation.
+struct SharedCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> bytesAllocated{0};
+    std::atomic<std::uint64_t> bytesFreed{0};
+};
+
+thread_local int tPhase = AllocationTracker::kOther;
+SharedCounters gCounters[AllocationTracker::kNumPhases];
+
+inline void countAlloc(void* p)
+{
+    auto& c = gCounters[tPhase];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytesAllocated.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+}
+
+inline void* countedAlloc(std::size_t size)
+{
+    void* p = std::malloc(size ? size : 1);
+    if (p) countAlloc(p);
+    return p;
+}
+
+inline void* countedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    void* p = nullptr;
+    if (posix_memalign(&p, std::max(static_cast<std::size_t>(align), sizeof(void*)),
+                       size ? size : 1) != 0)
+    {
+        return nullptr;
+    }
+    countAlloc(p);
+    return p;
+}
+
+inline void countedFree(void* p)
+{
+    if (!p) return;
+    auto& c = gCounters[tPhase];
+    c.deallocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytesFreed.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+    std::free(p);
+}
+
+}  // namespace
+
+void AllocationTracker::SetPhase(Phase phase) { tPhase = phase; }
+
+AllocationTracker::Snapshot AllocationTracker::Read()
+{
+    Snapshot s;
+    for (int i = 0; i < kNumPhases; ++i) {
+        s[i].allocations = gCounters[i].allocations.load(std::memory_order_relaxed);
+        s[i].deallocations = gCounters[i].deallocations.load(std::memory_order_relaxed);
+        s[i].bytesAllocated = gCounters[i].bytesAllocated.load(std::memory_order_relaxed);
+        s[i].bytesFreed = gCounters[i].bytesFreed.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size)
+{
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    if (void* p = countedAlignedAlloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    if (void* p = countedAlignedAlloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+#endif
+
+const char* AllocationTracker::PhaseName(Phase phase)
+{
+    switch (phase) {
+        case kGeneration: return "generation";
+        case kObservables: return "observables";
+        case kFill: return "analysis fill";
+        default: return "other";
+    }
+}
+
+namespace {
+
+std::uint64_t liveBytes(const AllocationTracker::Snapshot& s)
+{
+    std::uint64_t allocated = 0, freed = 0;
+    for (const auto& c : s) {
+        allocated += c.bytesAllocated;
+        freed += c.bytesFreed;
+    }
+    return allocated - freed;
+}
+
+}  // namespace
+
+AllocationReport::AllocationReport(G4int warmupEvents, G4int checkpointEvery)
+  : fWarmup(warmupEvents), fCheckpointEvery(std::max(checkpointEvery, 1))
+{}
+
+void AllocationReport::BeginEvent()
+{
+    fEventStart = AllocationTracker::Read();
+    if (fEvents == fWarmup) fSteadyStart = fEventStart;
+}
+
+void AllocationReport::EndEvent()
+{
+    AllocationTracker::SetPhase(AllocationTracker::kOther);
+    fLast = AllocationTracker::Read();
+    for (int i = 0; i < AllocationTracker::kNumPhases; ++i) {
+        const std::uint64_t n = fLast[i].allocations - fEventStart[i].allocations;
+        fMaxAllocsPerEvent[i] = std::max(fMaxAllocsPerEvent[i], n);
+    }
+    ++fEvents;
+    if (fEvents > fWarmup && (fEvents - fWarmup) % fCheckpointEvery == 0) {
+        fLiveBytes.emplace_back(fEvents, static_cast<G4double>(liveBytes(fLast)));
+    }
+}
+
+void AllocationReport::PrintRun(std::ostream& os, std::uint64_t numCollisions)
+{
+    os << "==== Heap allocation accounting ====" << std::endl;
+    if (!AllocationTracker::kEnabled) {
+        os << "Not available: rebuild with -DWITH_ALLOC_TRACKING=ON" << std::endl;
+        return;
+    }
+    const AllocationTracker::Snapshot s = AllocationTracker::Read();
+    os << numCollisions << " collisions, all threads, warm-up included" << std::endl;
+    os << std::left << std::setw(16) << "phase" << std::right << std::setw(14) << "allocs"
+       << std::setw(14) << "MB alloc" << std::setw(14) << "MB live" << std::setw(16)
+       << "allocs/coll" << std::endl;
+    for (int i = 0; i < AllocationTracker::kNumPhases; ++i) {
+        const auto& c = s[i];
+        os << std::left << std::setw(16) << AllocationTracker::PhaseName(AllocationTracker::Phase(i))
+           << std::right << std::setw(14) << c.allocations << std::fixed << std::setprecision(2)
+           << std::setw(14) << c.bytesAllocated / 1048576. << std::setw(14)
+           << (G4double(c.bytesAllocated) - G4double(c.bytesFreed)) / 1048576. << std::setw(16)
+           << (numCollisions > 0 ? G4double(c.allocations) / numCollisions : 0.) << std::defaultfloat
+           << std::endl;
+    }
+}
+
+void AllocationReport::Print(std::ostream& os) const
+{
+    os << "==== Heap allocation accounting ====" << std::endl;
+    if (!AllocationTracker::kEnabled) {
+        os << "Not available: rebuild with -DWITH_ALLOC_TRACKING=ON" << std::endl;
+        return;
+    }
+    const G4int steadyEvents = fEvents - fWarmup;
+    os << fEvents << " events, steady state after " << fWarmup << " warm-up events" << std::endl;
+    os << std::left << std::setw(16) << "phase" << std::right << std::setw(14) << "allocs"
+       << std::setw(14) << "MB alloc" << std::setw(14) << "MB live" << std::setw(16)
+       << "allocs/event" << std::setw(14) << "bytes/event" << std::setw(14) << "max/event"
+       << std::endl;
+
+    G4double totalSteadyAllocs = 0.;
+    for (int i = 0; i < AllocationTracker::kNumPhases; ++i) {
+        const auto& c = fLast[i];
+        const auto& s = fSteadyStart[i];
+        const G4double steadyAllocs = steadyEvents > 0 ? G4double(c.allocations - s.allocations) : 0.;
+        const G4double steadyBytes = steadyEvents > 0 ? G4double(c.bytesAllocated - s.bytesAllocated) : 0.;
+        totalSteadyAllocs += steadyAllocs;
+        os << std::left << std::setw(16) << AllocationTracker::PhaseName(AllocationTracker::Phase(i))
+           << std::right << std::setw(14) << c.allocations << std::fixed << std::setprecision(2)
+           << std::setw(14) << c.bytesAllocated / 1048576. << std::setw(14)
+           << (G4double(c.bytesAllocated) - G4double(c.bytesFreed)) / 1048576. << std::setw(16)
+           << (steadyEvents > 0 ? steadyAllocs / steadyEvents : 0.) << std::setw(14)
+           << (steadyEvents > 0 ? steadyBytes / steadyEvents : 0.) << std::setw(14)
+           << fMaxAllocsPerEvent[i] << std::defaultfloat << std::endl;
+    }
+    if (steadyEvents > 0) {
+        os << "Steady-state allocations per collision: " << totalSteadyAllocs / steadyEvents
+           << std::endl;
+    }
+
+    // Least-squares slope of live bytes versus event number over the steady state
+    if (fLiveBytes.size() >= 3) {
+        G4double sx = 0., sy = 0., sxx = 0., sxy = 0.;
+        for (const auto& [x, y] : fLiveBytes) {
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        const G4double n = fLiveBytes.size();
+        const G4double denom = n * sxx - sx * sx;
+        const G4double slope = denom != 0. ? (n * sxy - sx * sy) / denom : 0.;
+        const G4double growth = fLiveBytes.back().second - fLiveBytes.front().second;
+        os << "Live heap growth: " << slope << " bytes/event (" << growth / 1048576.
+           << " MB over " << fLiveBytes.back().first - fLiveBytes.front().first << " events)"
+           << std::endl;
+        if (slope > 1. && growth > 1048576.) {
+            os << "WARNING: live heap grows steadily; memory allocated per event is never freed"
+               << std::endl;
+        }
+    }
+}
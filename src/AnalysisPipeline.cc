@@ -0,0 +1,133 @@
+#include "AnalysisPipeline.hh"
+#include "AllocationTracker.hh"
+#include "BootstrapReplicas.hh"
+#include "Observables.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+// Idle analysis threads yield this many times before they start sleeping
+constexpr G4int kIdleSpins = 64;
+constexpr std::chrono::microseconds kIdleSleep(50);
+}  // namespace
+
+AnalysisPipeline::AnalysisPipeline(const std::vector<HadronicAnalysis*>& analyses,
+                                   std::size_t batchCollisions, std::size_t depth, G4int bootstrapReplicas,
+                                   std::uint64_t bootstrapSeed)
+    : fAnalyses(analyses),
+      fBatchCollisions(std::max<std::size_t>(batchCollisions, 1)),
+      fBootstrapReplicas(bootstrapReplicas),
+      fBootstrapSeed(bootstrapSeed),
+      fRing(std::max<std::size_t>(depth, 1)),
+      fCounters(analyses.size())
+{
+    for (std::size_t c = 0; c < fAnalyses.size(); ++c) {
+        fThreads.emplace_back(&AnalysisPipeline::Consume, this, c);
+    }
+}
+
+AnalysisPipeline::~AnalysisPipeline()
+{
+    fRing.Close();
+    for (auto& thread : fThreads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void AnalysisPipeline::ClaimBatch()
+{
+    fBatch = fRing.Claim();
+    if (fBatch == nullptr) {
+        // Back-pressure: the analysis threads are a whole ring behind
+        const auto start = Clock::now();
+        ++fStalls;
+        while ((fBatch = fRing.Claim()) == nullptr) std::this_thread::yield();
+        fStallTime += Clock::now() - start;
+    }
+    fBatch->events.clear();
+    fBatch->secondaries.clear();
+}
+
+void AnalysisPipeline::PublishBatch()
+{
+    fRing.Publish();
+    fBatch = nullptr;
+    ++fBatches;
+}
+
+void AnalysisPipeline::Consume(std::size_t consumer)
+{
+    HadronicAnalysis& analysis = *fAnalyses[consumer];
+    ConsumerCounters& counters = fCounters[consumer];
+    BootstrapWeights bootstrapWeights(fBootstrapReplicas, fBootstrapSeed);
+    EventInfo eventInfo;
+    G4int idle = 0;
+    for (;;) {
+        std::uint64_t ticket = 0;
+        Batch* batch = fRing.Acquire(ticket);
+        if (batch == nullptr) {
+            // Everything published before Close() is visible once it is seen
+            if (fRing.IsClosed() && (batch = fRing.Acquire(ticket)) == nullptr) return;
+            if (batch == nullptr) {
+                if (++idle < kIdleSpins) std::this_thread::yield();
+                else std::this_thread::sleep_for(kIdleSleep);
+                continue;
+            }
+        }
+        idle = 0;
+
+        const auto start = Clock::now();
+        for (const Event& event : batch->events) {
+            eventInfo.index = event.index;
+            if (fBootstrapReplicas > 0) {
+                bootstrapWeights.Draw(event.index);
+                eventInfo.bootstrapWeights = bootstrapWeights.Get();
+            }
+            eventInfo.generator = &event.record;
+            analysis.BeginEvent(eventInfo);
+            const Secondary* secondary = batch->secondaries.data() + event.firstSecondary;
+            for (std::uint32_t j = 0; j < event.numSecondaries; ++j, ++secondary) {
+                AllocationTracker::SetPhase(AllocationTracker::kObservables);
+                const Observables obs =
+                    computeObservables(secondary->p4, secondary->definition, event.cmsBoost, event.sqrtS);
+                AllocationTracker::SetPhase(AllocationTracker::kFill);
+                analysis.Fill(obs, secondary->definition);
+            }
+        }
+        AllocationTracker::SetPhase(AllocationTracker::kOther);
+        counters.secondaries += batch->secondaries.size();
+        ++counters.batches;
+        counters.busy += Clock::now() - start;
+        fRing.Release(ticket);
+    }
+}
+
+G4bool AnalysisPipeline::Finish()
+{
+    if (fBatch != nullptr && !fBatch->events.empty()) PublishBatch();
+    fRing.Close();
+    for (auto& thread : fThreads) {
+        if (thread.joinable()) thread.join();
+    }
+    G4bool ok = true;
+    for (std::size_t c = 1; c < fAnalyses.size(); ++c) {
+        ok = mergeAccumulators(*fAnalyses[0], *fAnalyses[c]) && ok;
+    }
+    return ok;
+}
+
+void AnalysisPipeline::PrintStatistics(std::ostream& os) const
+{
+    os << "Pipeline: " << fBatches << " batches of up to " << fBatchCollisions << " collisions, "
+       << fRing.Capacity() << " in flight, " << fAnalyses.size() << " analysis threads" << std::endl;
+    os << "  generation waited " << fStalls << " times for the analysis threads ("
+       << std::chrono::duration<G4double>(fStallTime).count() << " s)" << std::endl;
+    for (std::size_t c = 0; c < fCounters.size(); ++c) {
+        const ConsumerCounters& counters = fCounters[c];
+        os << "  analysis thread " << c << ": " << counters.batches << " batches, " << counters.secondaries
+           << " secondaries, busy " << std::fixed << std::setprecision(2)
+           << std::chrono::duration<G4double>(counters.busy).count() << " s" << std::defaultfloat
+           << std::endl;
+    }
+}
@@ -0,0 +1,27 @@
+#include "AnalysisRegistry.hh"
+
+#include <iostream>
+
+AnalysisRegistry& AnalysisRegistry::Instance() {
+    // Function-local static: safe to use from other translation units' static initialisers
+    static AnalysisRegistry registry;
+    return registry;
+}
+
+bool AnalysisRegistry::Register(const std::string& name, Factory factory) {
+    if (!fFactories.emplace(name, factory).second) {
+        std::cerr << "WARNING: Analysis " << name << " registered twice" << std::endl;
+    }
+    return true;
+}
+
+HadronicAnalysis* AnalysisRegistry::Create(const std::string& name) const {
+    auto it = fFactories.find(name);
+    return it == fFactories.end() ? nullptr : it->second();
+}
+
+std::vector<std::string> AnalysisRegistry::Names() const {
+    std::vector<std::string> names;
+    for (const auto& entry : fFactories) names.push_back(entry.first);
+    return names;
+}
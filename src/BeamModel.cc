@@ -0,0 +1,174 @@
+#include "BeamModel.hh"
+
+#include "G4ParticleDefinition.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+BeamModel::BeamModel(G4ParticleDefinition* projectile, G4double momentum)
+    : fProjectile(projectile), fMass(projectile->GetPDGMass()), fMomentum(momentum)
+{
+    fPx.resize(kBlockSize);
+    fPy.resize(kBlockSize);
+    fPz.resize(kBlockSize);
+    fEnergy.resize(kBlockSize);
+}
+
+G4bool BeamModel::LoadBeamFile(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        std::cerr << "ERROR: Cannot open beam file " << fileName << std::endl;
+        return false;
+    }
+    std::vector<std::vector<G4double>> rows;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        std::vector<G4double> row;
+        G4double x;
+        while (ss >> x) row.push_back(x);
+        if (row.empty()) continue;
+        if (!rows.empty() && row.size() != rows.front().size()) {
+            std::cerr << "ERROR: Inconsistent number of columns in beam file " << fileName << std::endl;
+            return false;
+        }
+        rows.push_back(row);
+    }
+
+    if (!rows.empty() && rows.front().size() == 3) {
+        for (const auto& r : rows) fBeamFile.emplace_back(r[0] * CLHEP::GeV, r[1] * CLHEP::GeV, r[2] * CLHEP::GeV);
+        return true;
+    }
+    if (rows.size() >= 2 && rows.front().size() == 2) {
+        fSpectrumCdf.push_back(0.);
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (i > 0 && rows[i][0] <= rows[i - 1][0]) {
+                std::cerr << "ERROR: Momenta in beam file " << fileName << " must increase" << std::endl;
+                return false;
+            }
+            fSpectrumEdges.push_back(rows[i][0] * CLHEP::GeV);
+            if (i + 1 < rows.size()) fSpectrumCdf.push_back(fSpectrumCdf.back() + std::max(rows[i][1], 0.));
+        }
+        if (fSpectrumCdf.back() <= 0.) {
+            std::cerr << "ERROR: Empty momentum spectrum in beam file " << fileName << std::endl;
+            return false;
+        }
+        for (auto& c : fSpectrumCdf) c /= fSpectrumCdf.back();
+        return true;
+    }
+    std::cerr << "ERROR: Beam file " << fileName
+              << " needs \"p weight\" or \"px py pz\" rows" << std::endl;
+    return false;
+}
+
+void BeamModel::SetTarget(const TargetModel& target)
+{
+    fTargetMasses.clear();
+    for (const auto& n : target.GetNuclei()) fTargetMasses.push_back(n.mass);
+    const std::size_t size = fTargetMasses.size() * kBlockSize;
+    fBx.assign(size, 0.);
+    fBy.assign(size, 0.);
+    fBz.assign(size, 0.);
+    fSqrtS.assign(size, 0.);
+    fNext = kBlockSize;
+}
+
+G4bool BeamModel::IsPencil() const
+{
+    return fRelativeSpread <= 0. && fDivergence <= 0. && fSpectrumEdges.empty() && fBeamFile.empty();
+}
+
+void BeamModel::FillBlock()
+{
+    SampleMomenta();
+    ComputeFrames();
+    fNext = 0;
+}
+
+void BeamModel::SampleMomenta()
+{
+    const std::size_t n = kBlockSize;
+    if (!fBeamFile.empty()) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const G4ThreeVector& p = fBeamFile[fBeamFileNext];
+            fBeamFileNext = (fBeamFileNext + 1) % fBeamFile.size();
+            fPx[i] = p.x();
+            fPy[i] = p.y();
+            fPz[i] = p.z();
+        }
+    }
+    else if (IsPencil()) {
+        std::fill(fPx.begin(), fPx.end(), 0.);
+        std::fill(fPy.begin(), fPy.end(), 0.);
+        std::fill(fPz.begin(), fPz.end(), fMomentum);
+    }
+    else {
+        // Uniform deviates for the whole block in one call: 2 for the
+        // momentum (Box-Muller or spectrum), 2 for the divergence
+        fRandom.resize(4 * n);
+        fEngine.flatArray(static_cast<int>(fRandom.size()), fRandom.data());
+        const G4double* u = fRandom.data();
+
+        // |p| goes to fPz for now, the direction is applied below
+        if (!fSpectrumEdges.empty()) {
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::size_t bin = std::min<std::size_t>(
+                    std::upper_bound(fSpectrumCdf.begin(), fSpectrumCdf.end(), u[i]) - fSpectrumCdf.begin(),
+                    fSpectrumCdf.size() - 1) - 1;
+                fPz[i] = fSpectrumEdges[bin] + u[n + i] * (fSpectrumEdges[bin + 1] - fSpectrumEdges[bin]);
+            }
+        }
+        else {
+            const G4double sigma = fRelativeSpread * fMomentum;
+            for (std::size_t i = 0; i < n; ++i) {
+                const G4double r = std::sqrt(-2. * std::log(1. - u[i]));
+                fPz[i] = std::max(fMomentum + sigma * r * std::cos(CLHEP::twopi * u[n + i]), 0.);
+            }
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const G4double r = fDivergence * std::sqrt(-2. * std::log(1. - u[2 * n + i]));
+            const G4double phi = CLHEP::twopi * u[3 * n + i];
+            // Projected angles, both Gaussian; direction (tan tx, tan ty, 1)
+            const G4double tx = std::tan(r * std::cos(phi));
+            const G4double ty = std::tan(r * std::sin(phi));
+            const G4double pz = fPz[i] / std::sqrt(1. + tx * tx + ty * ty);
+            fPx[i] = tx * pz;
+            fPy[i] = ty * pz;
+            fPz[i] = pz;
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        fEnergy[i] = std::sqrt(fPx[i] * fPx[i] + fPy[i] * fPy[i] + fPz[i] * fPz[i] + fMass * fMass);
+    }
+}
+
+void BeamModel::ComputeFrames()
+{
+    // One pass per nucleus over contiguous arrays, free of branches so that
+    // the compiler can vectorise it
+    const std::size_t n = kBlockSize;
+    for (std::size_t k = 0; k < fTargetMasses.size(); ++k) {
+        const G4double m = fTargetMasses[k];
+        G4double* bx = fBx.data() + k * n;
+        G4double* by = fBy.data() + k * n;
+        G4double* bz = fBz.data() + k * n;
+        G4double* sqrtS = fSqrtS.data() + k * n;
+        for (std::size_t i = 0; i < n; ++i) {
+            const G4double e = fEnergy[i] + m;
+            const G4double inv = 1. / e;
+            bx[i] = fPx[i] * inv;
+            by[i] = fPy[i] * inv;
+            bz[i] = fPz[i] * inv;
+            // s = (E + M)^2 - p^2 = m_beam^2 + M^2 + 2 E M
+            sqrtS[i] = std::sqrt(fMass * fMass + m * m + 2. * fEnergy[i] * m);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include "Chi2Monitor.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+Chi2Monitor::Chi2Monitor(G4double threshold, std::int64_t interval, std::int64_t totalCollisions,
+                         G4double numSigma)
+    : fThreshold(threshold),
+      fInterval(std::max<std::int64_t>(interval, 1)),
+      fTotal(std::max<std::int64_t>(totalCollisions, 1)),
+      fNumSigma(numSigma),
+      fNext(fInterval)
+{}
+
+G4bool Chi2Monitor::IsEnabled(const HadronicAnalysis& analysis) const
+{
+    return !analysis.CompareToReference(1).empty();
+}
+
+Chi2Monitor::Summary Chi2Monitor::Compare(const std::vector<ReferencePoint>& points,
+                                          std::int64_t collisions) const
+{
+    // The variance left at the end of the run, relative to the current one
+    const G4double remaining = std::min(1., static_cast<G4double>(collisions) / fTotal);
+    Summary summary;
+    for (const auto& point : points) {
+        const G4double dataVariance = point.dataError * point.dataError;
+        const G4double variance = dataVariance + point.mcVariance;
+        if (!std::isfinite(point.data) || !(variance > 0.)) continue;
+        const G4double distance = std::abs(point.mc - point.data);
+        ++summary.numPoints;
+        summary.chi2 += distance * distance / variance;
+        summary.maxPull = std::max(summary.maxPull, distance / std::sqrt(variance));
+        const G4double lower = std::max(0., distance - fNumSigma * std::sqrt(point.mcVariance));
+        const G4double finalVariance = dataVariance + point.mcVariance * remaining;
+        if (finalVariance > 0.) summary.chi2Lower += lower * lower / finalVariance;
+    }
+    return summary;
+}
+
+G4bool Chi2Monitor::Check(const HadronicAnalysis& analysis, std::int64_t collisions, std::ostream& os)
+{
+    fNext = collisions + fInterval;
+    if (collisions <= 0) return false;
+    fLast = Compare(analysis.CompareToReference(static_cast<G4int>(collisions)), collisions);
+    if (fLast.numPoints == 0) return false;
+    const G4double ndf = static_cast<G4double>(fLast.numPoints);
+    os << "chi2/ndf after " << collisions << " collisions: " << std::fixed << std::setprecision(3)
+       << fLast.chi2 / ndf << " (at least " << fLast.chi2Lower / ndf << " at the end), "
+       << fLast.numPoints << " points, max pull " << std::setprecision(2) << fLast.maxPull
+       << std::defaultfloat << std::endl;
+    return fLast.chi2Lower / ndf > fThreshold;
+}
@@ -0,0 +1,199 @@
+#include "ChunkScheduler.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+#include <utility>
+
+namespace {
+// Collisions in the first chunk of every configuration, before its cost is known
+constexpr std::int64_t kProbeCollisions = 8;
+// Assumed cost per collision while nothing has been measured yet
+constexpr G4double kDefaultCost = 1.e-3;
+// Chunk duration: this fraction of the remaining work per worker, within limits
+constexpr G4double kChunksPerWorker = 4.;
+constexpr G4double kMinChunkSeconds = 0.05;
+constexpr G4double kMaxChunkSeconds = 10.;
+}  // namespace
+
+ChunkScheduler::ChunkScheduler(const std::vector<std::int64_t>& collisionsPerConfig,
+                               std::size_t numWorkers)
+    : fConfigs(collisionsPerConfig.size()), fWorkers(std::max<std::size_t>(numWorkers, 1))
+{
+    for (std::size_t c = 0; c < fConfigs.size(); ++c) {
+        fConfigs[c].total = std::max<std::int64_t>(collisionsPerConfig[c], 0);
+    }
+}
+
+void ChunkScheduler::Run(const WorkerFunction& init, const ChunkFunction& run,
+                         const std::function<void()>& poll)
+{
+    // Deal one probe chunk per configuration round-robin, so that every cost
+    // is measured early and on different workers
+    std::size_t w = 0;
+    for (std::size_t c = 0; c < fConfigs.size(); ++c) {
+        Config& config = fConfigs[c];
+        if (config.next >= config.total) continue;
+        const std::int64_t n = std::min(kProbeCollisions, config.total - config.next);
+        fWorkers[w].chunks.push_back({c, config.next, n});
+        config.next += n;
+        w = (w + 1) % fWorkers.size();
+    }
+
+    fStart = Clock::now();
+    fRunning = fWorkers.size();
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < fWorkers.size(); ++i) {
+        threads.emplace_back(&ChunkScheduler::WorkerLoop, this, i, std::cref(init), std::cref(run));
+    }
+    while (fRunning.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (poll) poll();
+    }
+    for (auto& thread : threads) thread.join();
+    fEnd = Clock::now();
+}
+
+void ChunkScheduler::WorkerLoop(std::size_t worker, const WorkerFunction& init, const ChunkFunction& run)
+{
+    if (init) init(worker);
+    Worker& self = fWorkers[worker];
+    Chunk chunk;
+    while (PopOwn(worker, chunk) || Steal(worker, chunk) || Carve(worker, chunk)) {
+        const auto start = Clock::now();
+        run(worker, chunk);
+        const G4double seconds = std::chrono::duration<G4double>(Clock::now() - start).count();
+        Complete(chunk, seconds);
+        self.busy += seconds;
+        ++self.chunksRun;
+    }
+    self.finished = Clock::now();
+    --fRunning;
+}
+
+G4bool ChunkScheduler::PopOwn(std::size_t worker, Chunk& chunk)
+{
+    Worker& self = fWorkers[worker];
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (self.chunks.empty()) return false;
+    chunk = self.chunks.back();
+    self.chunks.pop_back();
+    return true;
+}
+
+G4bool ChunkScheduler::Steal(std::size_t worker, Chunk& chunk)
+{
+    for (std::size_t k = 1; k < fWorkers.size(); ++k) {
+        Worker& victim = fWorkers[(worker + k) % fWorkers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.chunks.empty()) continue;
+        // The oldest chunk: the owner works from the other end
+        chunk = victim.chunks.front();
+        victim.chunks.pop_front();
+        ++fWorkers[worker].stolen;
+        return true;
+    }
+    return false;
+}
+
+G4double ChunkScheduler::Cost(const Config& config) const
+{
+    if (config.measured > 0) return config.seconds / config.measured;
+    G4double cost = 0.;
+    for (const auto& c : fConfigs) {
+        if (c.measured > 0) cost = std::max(cost, c.seconds / c.measured);
+    }
+    return cost > 0. ? cost : kDefaultCost;
+}
+
+G4bool ChunkScheduler::Carve(std::size_t worker, Chunk& chunk)
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    // Estimated remaining seconds, and the configuration with the most of them
+    G4double remaining = 0.;
+    G4double largest = 0.;
+    std::size_t best = fConfigs.size();
+    for (std::size_t c = 0; c < fConfigs.size(); ++c) {
+        const Config& config = fConfigs[c];
+        if (config.next >= config.total) continue;
+        const G4double seconds = (config.total - config.next) * Cost(config);
+        remaining += seconds;
+        if (best == fConfigs.size() || seconds > largest) {
+            largest = seconds;
+            best = c;
+        }
+    }
+    if (best == fConfigs.size()) return false;
+
+    const G4double target = std::clamp(remaining / (kChunksPerWorker * fWorkers.size()),
+                                       kMinChunkSeconds, kMaxChunkSeconds);
+    Config& config = fConfigs[best];
+    const G4double cost = Cost(config);
+    auto take = [&config, target, cost]() {
+        const std::int64_t n = std::clamp<std::int64_t>(std::llround(target / cost), 1,
+                                                        config.total - config.next);
+        const std::int64_t first = config.next;
+        config.next += n;
+        return std::make_pair(first, n);
+    };
+
+    const auto [first, count] = take();
+    chunk = {best, first, count};
+
+    // While more than a round of chunks is left, put a second one up for
+    // stealing, so that idle workers find it without coming back here
+    if (config.next < config.total && remaining - count * cost > target * fWorkers.size()) {
+        const auto [first2, count2] = take();
+        Worker& self = fWorkers[worker];
+        std::lock_guard<std::mutex> ownLock(self.mutex);
+        self.chunks.push_back({best, first2, count2});
+    }
+    return true;
+}
+
+void ChunkScheduler::Complete(const Chunk& chunk, G4double seconds)
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    Config& config = fConfigs[chunk.config];
+    config.measured += chunk.count;
+    config.seconds += seconds;
+    ++config.chunks;
+}
+
+void ChunkScheduler::PrintStatistics(std::ostream& os) const
+{
+    const G4double wall = std::chrono::duration<G4double>(fEnd - fStart).count();
+    G4double busy = 0.;
+    Clock::time_point firstIdle = fEnd;
+    for (const auto& w : fWorkers) {
+        busy += w.busy;
+        firstIdle = std::min(firstIdle, w.finished);
+    }
+
+    os << "==== Scheduler: " << fConfigs.size() << " configurations on " << fWorkers.size()
+       << " workers ====" << std::endl;
+    os << std::right << std::setw(8) << "config" << std::setw(12) << "collisions" << std::setw(8)
+       << "chunks" << std::setw(12) << "cpu[s]" << std::setw(14) << "ms/collision" << std::endl;
+    for (std::size_t c = 0; c < fConfigs.size(); ++c) {
+        const Config& config = fConfigs[c];
+        os << std::setw(8) << c << std::setw(12) << config.measured << std::setw(8) << config.chunks
+           << std::fixed << std::setprecision(2) << std::setw(12) << config.seconds
+           << std::setprecision(4) << std::setw(14)
+           << (config.measured > 0 ? 1.e3 * config.seconds / config.measured : 0.) << std::defaultfloat
+           << std::endl;
+    }
+    os << std::setw(8) << "worker" << std::setw(12) << "busy[s]" << std::setw(8) << "chunks"
+       << std::setw(12) << "stolen" << std::setw(14) << "idle tail[s]" << std::endl;
+    for (std::size_t i = 0; i < fWorkers.size(); ++i) {
+        const Worker& w = fWorkers[i];
+        os << std::setw(8) << i << std::fixed << std::setprecision(2) << std::setw(12) << w.busy
+           << std::setw(8) << w.chunksRun << std::setw(12) << w.stolen << std::setw(14)
+           << std::chrono::duration<G4double>(fEnd - w.finished).count() << std::defaultfloat
+           << std::endl;
+    }
+    os << "wall " << wall << " s, utilisation "
+       << (wall > 0. ? 100. * busy / (wall * fWorkers.size()) : 0.) << " %, tail (first worker idle to end) "
+       << std::chrono::duration<G4double>(fEnd - firstIdle).count() << " s" << std::endl;
+}
@@ -0,0 +1,193 @@
+#include "CrossSectionTable.hh"
+#include "HadronicGenerator.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4Material.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Version.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kMagic[8] = {'T', 'T', 'S', 'X', 'S', 'E', 'C', '1'};
+
+struct CacheHeader {
+    char magic[8];
+    std::int32_t g4Version;
+    std::int32_t numPoints;
+    G4double logPMin;
+    G4double logPMax;
+    std::uint64_t numEntries;
+    char physics[32];
+};
+
+struct CacheEntry {
+    char projectile[32];
+    char material[32];
+    G4double sigma[CrossSectionTable::kNumPoints];  // internal units
+};
+
+void copyName(char (&dst)[32], const std::string& src)
+{
+    std::memset(dst, 0, sizeof(dst));
+    std::strncpy(dst, src.c_str(), sizeof(dst) - 1);
+}
+
+std::string name(const char (&src)[32])
+{
+    return std::string(src, strnlen(src, sizeof(src)));
+}
+
+G4double gridMomentum(G4int i)
+{
+    const G4double step = (CrossSectionTable::kLogPMax - CrossSectionTable::kLogPMin)
+                          / (CrossSectionTable::kNumPoints - 1);
+    return std::pow(10., CrossSectionTable::kLogPMin + i * step) * CLHEP::GeV;
+}
+}  // namespace
+
+CrossSectionTable::CrossSectionTable(const std::string& physics, const std::string& cacheFile)
+    : fPhysics(physics), fCacheFile(cacheFile)
+{
+    if (fCacheFile.empty()) {
+        fCacheFile = "xsec_" + physics + "_g4" + std::to_string(G4VERSION_NUMBER) + ".cache";
+    }
+    Load();
+}
+
+CrossSectionTable::~CrossSectionTable()
+{
+    if (fMapping) munmap(fMapping, fMappingSize);
+}
+
+void CrossSectionTable::Load()
+{
+    const int fd = open(fCacheFile.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(CacheHeader)) {
+        close(fd);
+        return;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return;
+    fMapping = p;
+    fMappingSize = st.st_size;
+
+    // A cache of another Geant4 version, physics case or grid is ignored and
+    // replaced by the next Require() that evaluates anything
+    const auto* header = static_cast<const CacheHeader*>(p);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->g4Version != G4VERSION_NUMBER
+        || header->numPoints != kNumPoints || header->logPMin != kLogPMin || header->logPMax != kLogPMax
+        || name(header->physics) != fPhysics
+        || fMappingSize < sizeof(CacheHeader) + header->numEntries * sizeof(CacheEntry))
+    {
+        std::cerr << "WARNING: Ignoring cross-section cache " << fCacheFile
+                  << " (other Geant4 version, physics case or format)" << std::endl;
+        return;
+    }
+    const auto* entries = reinterpret_cast<const CacheEntry*>(static_cast<const char*>(p) + sizeof(CacheHeader));
+    for (std::uint64_t i = 0; i < header->numEntries; ++i) {
+        fGrids[{name(entries[i].projectile), name(entries[i].material)}] = entries[i].sigma;
+    }
+}
+
+std::vector<G4double> CrossSectionTable::Evaluate(HadronicGenerator& generator,
+                                                  G4ParticleDefinition* projectile, G4Material* material)
+{
+    std::vector<G4double> sigma(kNumPoints, 0.);
+    G4HadronicProcess* process = generator.FindHadronicProcess(projectile);
+    const G4double atoms = material->GetTotNbOfAtomsPerVolume();
+    if (!process || atoms <= 0.) return sigma;
+
+    const std::size_t numElements = material->GetNumberOfElements();
+    const G4double* atomsPerVolume = material->GetVecNbOfAtomsPerVolume();
+    for (G4int i = 0; i < kNumPoints; ++i) {
+        const G4DynamicParticle particle(projectile, G4ThreeVector(0., 0., gridMomentum(i)));
+        G4double macroscopic = 0.;
+        for (std::size_t e = 0; e < numElements; ++e) {
+            macroscopic += atomsPerVolume[e]
+                           * process->GetElementCrossSection(&particle, material->GetElement(e), material);
+        }
+        sigma[i] = macroscopic / atoms;
+    }
+    return sigma;
+}
+
+void CrossSectionTable::Require(HadronicGenerator& generator,
+                                const std::vector<std::pair<G4ParticleDefinition*, G4Material*>>& pairs)
+{
+    // The Geant4 datasets keep per-thread caches and the generator's processes
+    // belong to the calling thread, so the grid points are evaluated here, in
+    // sequence; a pair costs a few hundred dataset calls, once per cache file
+    G4bool added = false;
+    for (const auto& [projectile, material] : pairs) {
+        const Key key{projectile->GetParticleName(), material->GetName()};
+        if (fGrids.count(key)) continue;
+        auto& grid = fEvaluated[key];
+        grid = Evaluate(generator, projectile, material);
+        fGrids[key] = grid.data();
+        added = true;
+    }
+    if (added && !Write()) {
+        std::cerr << "WARNING: Cannot write cross-section cache " << fCacheFile << std::endl;
+    }
+}
+
+G4bool CrossSectionTable::Write() const
+{
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.g4Version = G4VERSION_NUMBER;
+    header.numPoints = kNumPoints;
+    header.logPMin = kLogPMin;
+    header.logPMax = kLogPMax;
+    header.numEntries = fGrids.size();
+    copyName(header.physics, fPhysics);
+
+    const std::string tmpFile = fCacheFile + ".tmp" + std::to_string(getpid());
+    std::FILE* out = std::fopen(tmpFile.c_str(), "wb");
+    if (!out) return false;
+    G4bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    for (const auto& [key, sigma] : fGrids) {
+        CacheEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        copyName(entry.projectile, key.first);
+        copyName(entry.material, key.second);
+        std::memcpy(entry.sigma, sigma, sizeof(entry.sigma));
+        ok = ok && std::fwrite(&entry, sizeof(entry), 1, out) == 1;
+    }
+    ok = std::fclose(out) == 0 && ok;
+    // The old file stays mapped (and valid) until this table is destroyed
+    if (!ok || std::rename(tmpFile.c_str(), fCacheFile.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+G4double CrossSectionTable::Inelastic(const G4ParticleDefinition* projectile, const G4Material* material,
+                                      G4double momentum) const
+{
+    const auto it = fGrids.find({projectile->GetParticleName(), material->GetName()});
+    if (it == fGrids.end() || momentum <= 0.) return 0.;
+    const G4double* sigma = it->second;
+
+    const G4double x = (std::log10(momentum / CLHEP::GeV) - kLogPMin) / (kLogPMax - kLogPMin)
+                       * (kNumPoints - 1);
+    if (x <= 0.) return sigma[0];
+    if (x >= kNumPoints - 1) return sigma[kNumPoints - 1];
+    const G4int i = static_cast<G4int>(x);
+    const G4double f = x - i;
+    return (1. - f) * sigma[i] + f * sigma[i + 1];
+}
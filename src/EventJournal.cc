@@ -0,0 +1,111 @@
+#include "EventJournal.hh"
+
+#include "G4Version.hh"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kMagic[8] = {'T', 'T', 'S', 'J', 'R', 'N', 'L', '1'};
+
+void copyName(char (&dst)[32], const std::string& src)
+{
+    std::memset(dst, 0, sizeof(dst));
+    std::strncpy(dst, src.c_str(), sizeof(dst) - 1);
+}
+}  // namespace
+
+std::uint64_t EventJournal::EventSeed(std::int64_t runSeed, std::int64_t event)
+{
+    // SplitMix64 finaliser of (run seed, event): neighbouring events get
+    // unrelated seeds, and each one is known without replaying the others
+    std::uint64_t z = static_cast<std::uint64_t>(runSeed) * 0x9E3779B97F4A7C15ULL
+                      + static_cast<std::uint64_t>(event) + 1;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    // CLHEP engines take a long; keep it positive
+    return z >> 1;
+}
+
+JournalHeader EventJournal::MakeHeader(std::int64_t runSeed, std::int64_t numCollisions,
+                                       const std::string& physics, const std::string& projectile,
+                                       const std::string& material, G4double thickness)
+{
+    JournalHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.headerSize = sizeof(JournalHeader);
+    h.recordSize = sizeof(JournalRecord);
+    h.runSeed = runSeed;
+    h.numCollisions = numCollisions;
+    h.g4Version = G4VERSION_NUMBER;
+    h.thickness = thickness;
+    copyName(h.physics, physics);
+    copyName(h.projectile, projectile);
+    copyName(h.material, material);
+    return h;
+}
+
+EventJournal::~EventJournal()
+{
+    if (fMapping) munmap(fMapping, fSize);
+}
+
+G4bool EventJournal::Map(int fd, std::size_t size, G4bool writable)
+{
+    void* p = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    fMapping = p;
+    fSize = size;
+    fHeader = static_cast<JournalHeader*>(p);
+    fRecords = reinterpret_cast<JournalRecord*>(static_cast<char*>(p) + sizeof(JournalHeader));
+    return true;
+}
+
+G4bool EventJournal::Create(const std::string& fileName, const JournalHeader& header)
+{
+    const std::size_t size = sizeof(JournalHeader) + header.numCollisions * sizeof(JournalRecord);
+    const int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        if (fd >= 0) close(fd);
+        std::cerr << "ERROR: Cannot create journal " << fileName << std::endl;
+        return false;
+    }
+    if (!Map(fd, size, true)) {
+        std::cerr << "ERROR: Cannot map journal " << fileName << std::endl;
+        return false;
+    }
+    // Records of collisions never started stay zero, i.e. seed 0 and no beam
+    *fHeader = header;
+    return true;
+}
+
+G4bool EventJournal::Open(const std::string& fileName)
+{
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(JournalHeader)) {
+        if (fd >= 0) close(fd);
+        std::cerr << "ERROR: Cannot read journal " << fileName << std::endl;
+        return false;
+    }
+    if (!Map(fd, st.st_size, false)) {
+        std::cerr << "ERROR: Cannot map journal " << fileName << std::endl;
+        return false;
+    }
+    if (std::memcmp(fHeader->magic, kMagic, sizeof(kMagic)) != 0
+        || fHeader->headerSize != sizeof(JournalHeader) || fHeader->recordSize != sizeof(JournalRecord)
+        || fSize < sizeof(JournalHeader) + fHeader->numCollisions * sizeof(JournalRecord))
+    {
+        std::cerr << "ERROR: " << fileName << " is not a ThinTargetSim journal of this version"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#include "ForkPool.hh"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+G4bool writeAll(int fd, const void* data, std::size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+G4bool readAll(int fd, void* data, std::size_t size)
+{
+    char* p = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+}  // namespace
+
+G4int ForkPool::Start()
+{
+    // Anything buffered now would otherwise be written once per worker
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    for (std::size_t w = 0; w < fNumWorkers; ++w) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::cerr << "ERROR: pipe() failed for worker " << w << std::endl;
+            break;
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            for (const int fd : fPipes) close(fd);
+            fPipes.clear();
+            fPids.clear();
+            fPipe = fds[1];
+            return static_cast<G4int>(w);
+        }
+        close(fds[1]);
+        if (pid < 0) {
+            close(fds[0]);
+            std::cerr << "ERROR: fork() failed for worker " << w << std::endl;
+            break;
+        }
+        fPids.push_back(pid);
+        fPipes.push_back(fds[0]);
+    }
+    if (fPids.size() == fNumWorkers) return -1;
+
+    for (const pid_t pid : fPids) kill(pid, SIGTERM);
+    Wait();
+    return -2;
+}
+
+G4bool ForkPool::Send(const G4double* data, std::size_t size)
+{
+    const std::uint64_t n = size;
+    return writeAll(fPipe, &n, sizeof(n)) && writeAll(fPipe, data, size * sizeof(G4double));
+}
+
+void ForkPool::Exit(G4bool ok)
+{
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    close(fPipe);
+    _exit(ok ? 0 : 1);
+}
+
+G4bool ForkPool::Receive(std::size_t worker, std::vector<G4double>& data)
+{
+    std::uint64_t n = 0;
+    if (!readAll(fPipes[worker], &n, sizeof(n))) return false;
+    data.resize(n);
+    return readAll(fPipes[worker], data.data(), n * sizeof(G4double));
+}
+
+G4bool ForkPool::Wait()
+{
+    // Closed first: a worker still writing results nobody reads gets EPIPE
+    for (const int fd : fPipes) close(fd);
+    G4bool ok = true;
+    for (std::size_t w = 0; w < fPids.size(); ++w) {
+        int status = 0;
+        while (waitpid(fPids[w], &status, 0) < 0 && errno == EINTR) {}
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "ERROR: Worker " << w << " failed" << std::endl;
+            ok = false;
+        }
+    }
+    fPids.clear();
+    fPipes.clear();
+    return ok;
+}
@@ -0,0 +1,170 @@
+#include "GenericYodaAnalysis.hh"
+#include "HistogramUtils.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include "YODA/ReaderYODA.h"
+#include "YODA/WriterYODA.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+GenericYodaAnalysis::GenericYodaAnalysis(const std::string& referenceFile)
+  : fReferenceFile(referenceFile)
+{
+    const auto slash = referenceFile.find_last_of('/');
+    fName = referenceFile.substr(slash == std::string::npos ? 0 : slash + 1);
+    fName = fName.substr(0, fName.rfind(".yoda"));
+}
+
+std::string GenericYodaAnalysis::GetName() const {
+    return fName;
+}
+
+std::vector<std::string> GenericYodaAnalysis::GetOutputFiles() const {
+    const std::string base = GetOutputName() + "_MC";
+    std::vector<std::string> files{base + ".yoda"};
+    if (GetRunInfo().bootstrapReplicas > 0) {
+        for (auto& file : bootstrapFiles(base)) files.push_back(file);
+    }
+    return files;
+}
+
+GenericYodaAnalysis::Variable GenericYodaAnalysis::ParseVariable(const std::string& name) {
+    if (name.empty() || name == "p") return kMomentum;
+    if (name == "pt") return kPt;
+    if (name == "T" || name == "Ekin") return kKineticEnergy;
+    if (name == "xF") return kXF;
+    if (name == "y") return kRapidity;
+    if (name == "theta") return kTheta;
+    throw std::runtime_error("Unknown Variable annotation: " + name);
+}
+
+double GenericYodaAnalysis::Value(Variable variable, const Observables& obs) {
+    switch (variable) {
+        case kPt: return obs.pt_lab / CLHEP::GeV;
+        case kKineticEnergy: return obs.T_lab / CLHEP::GeV;
+        case kXF: return obs.xF;
+        case kRapidity: return obs.y_cms;
+        case kTheta: return obs.theta_lab / CLHEP::milliradian;
+        default: return obs.p_lab.mag() / CLHEP::GeV;
+    }
+}
+
+void GenericYodaAnalysis::Initialize(G4int numCollisions) {
+    std::vector<YODA::AnalysisObject*> aovec;
+    YODA::ReaderYODA::create().read(fReferenceFile, aovec);
+
+    for (const auto* ao : aovec) {
+        const auto* est = dynamic_cast<const YODA::Estimate1D*>(ao);
+        if (!est || !ao->hasAnnotation("Secondary") || !ao->hasAnnotation("Theta range")) continue;
+
+        const int pdg = pdgFromName(ao->annotation("Secondary"));
+        const auto [thetaMin, thetaMax] = parseThetaRange(ao->annotation("Theta range"));
+        const Variable variable =
+            ParseVariable(ao->hasAnnotation("Variable") ? ao->annotation("Variable") : "");
+
+        const std::size_t object = fHistos.Book(*est);
+        auto species = std::find_if(fSpecies.begin(), fSpecies.end(),
+                                    [pdg](const SpeciesSelector& s) { return s.pdg == pdg; });
+        if (species == fSpecies.end()) {
+            fSpecies.push_back({pdg, {}});
+            species = fSpecies.end() - 1;
+        }
+        species->slices.push_back({thetaMin, thetaMax, variable, object});
+    }
+    for (const auto* ao : aovec) delete ao;
+
+    for (auto& species : fSpecies) {
+        std::sort(species.slices.begin(), species.slices.end(),
+                  [](const SliceSelector& a, const SliceSelector& b) { return a.thetaMin < b.thetaMin; });
+    }
+    if (GetRunInfo().bootstrapReplicas > 0) fReplicas.Book(fHistos.NumBins(), GetRunInfo().bootstrapReplicas);
+    fNumCollisions = numCollisions;
+
+    std::cout << GetName() << ": booked " << fHistos.NumObjects() << " histograms for "
+              << fSpecies.size() << " secondary species from " << fReferenceFile << std::endl;
+}
+
+inline void GenericYodaAnalysis::FillObject(std::size_t object, double x) {
+    const int bin = fHistos.Fill(object, x);
+    if (bin >= 0 && fBootstrapWeights && fReplicas.Enabled()) fReplicas.Fill(bin, fBootstrapWeights);
+}
+
+void GenericYodaAnalysis::BeginEvent(const EventInfo& event) {
+    fBootstrapWeights = event.bootstrapWeights;
+}
+
+void GenericYodaAnalysis::Fill(const Observables& obs, const G4ParticleDefinition* pd) {
+    const int pdg = pd->GetPDGEncoding();
+    for (const auto& species : fSpecies) {
+        if (species.pdg != pdg) continue;
+
+        const double thetaMrad = obs.theta_lab / CLHEP::milliradian;
+        // Each variable is computed at most once per secondary
+        double values[kNumVariables];
+        unsigned computed = 0;
+        for (const auto& slice : species.slices) {
+            if (thetaMrad < slice.thetaMin) break;
+            if (thetaMrad >= slice.thetaMax) continue;
+            if (!(computed & (1u << slice.variable))) {
+                values[slice.variable] = Value(slice.variable, obs);
+                computed |= 1u << slice.variable;
+            }
+            FillObject(slice.object, values[slice.variable]);
+        }
+        return;
+    }
+}
+
+AnalysisAcceptance GenericYodaAnalysis::GetAcceptance() const {
+    AnalysisAcceptance acceptance;
+    if (fHistos.NumObjects() == 0) return acceptance;
+
+    // A momentum window is only known when every object histograms p
+    double thetaMax = 0.;
+    double pMin = std::numeric_limits<double>::max();
+    double pMax = 0.;
+    G4bool allMomentum = true;
+    for (const auto& species : fSpecies) {
+        acceptance.pdgCodes.push_back(species.pdg);
+        for (const auto& slice : species.slices) {
+            thetaMax = std::max(thetaMax, slice.thetaMax);
+            if (slice.variable != kMomentum) {
+                allMomentum = false;
+                continue;
+            }
+            pMin = std::min(pMin, fHistos.XMin(slice.object));
+            pMax = std::max(pMax, fHistos.XMax(slice.object));
+        }
+    }
+    acceptance.maxThetaLab = std::min(thetaMax * CLHEP::milliradian, CLHEP::pi);
+    if (allMomentum) {
+        acceptance.minMomentum = pMin * CLHEP::GeV;
+        acceptance.maxMomentum = pMax * CLHEP::GeV;
+    }
+    return acceptance;
+}
+
+std::vector<AccumulatorBlock> GenericYodaAnalysis::Accumulators() {
+    std::vector<AccumulatorBlock> blocks{{fHistos.Data(), fHistos.DataSize()}};
+    if (fReplicas.Enabled()) blocks.push_back({fReplicas.Data(), fReplicas.DataSize()});
+    return blocks;
+}
+
+void GenericYodaAnalysis::Finalize() {
+    std::vector<YODA::AnalysisObject*> out;
+    for (std::size_t i = 0; i < fHistos.NumObjects(); ++i) out.push_back(fHistos.ToHisto(i));
+    const std::string base = GetOutputName() + "_MC";
+    YODA::WriterYODA::create().write(base + ".yoda", out);
+    std::cout << "Saved " << base << ".yoda" << std::endl;
+    if (fReplicas.Enabled()) {
+        // Booking order is the replica bin order
+        std::vector<YODA::Histo1D*> histos;
+        for (auto* ao : out) histos.push_back(static_cast<YODA::Histo1D*>(ao));
+        writeBootstrap(base, histos, fReplicas);
+        std::cout << "Saved " << base << "_bootstrap.yoda" << std::endl;
+    }
+    for (auto* ao : out) delete ao;
+}
@@ -1,16 +1,12 @@
 #include "HadronicAnalysisLoader.hh"
+#include "AnalysisRegistry.hh"
+#include "GenericYodaAnalysis.hh"
 #include <dlfcn.h>
 #include <iostream>
 
 typedef HadronicAnalysis* (*CreateFunc)();
 
-HadronicAnalysis* LoadAnalysis(const std::string& libPath, void** handleOut) {
-    void* handle = dlopen(libPath.c_str(), RTLD_LAZY);
-    if (!handle) {
-        std::cerr << "ERROR: Failed to load " << libPath << ": " << dlerror() << std::endl;
-        return nullptr;
-    }
-
+static HadronicAnalysis* CreateFromHandle(void* handle, const std::string& libPath, void** handleOut) {
     CreateFunc create = (CreateFunc) dlsym(handle, "CreateAnalysis");
     if (!create) {
         std::cerr << "ERROR: Cannot find CreateAnalysis in " << libPath << std::endl;
@@ -22,6 +18,44 @@ HadronicAnalysis* LoadAnalysis(const std::string& libPath, void** handleOut) {
     return create();
 }
 
+HadronicAnalysis* LoadAnalysis(const std::string& libPath, void** handleOut) {
+    void* handle = dlopen(libPath.c_str(), RTLD_LAZY);
+    if (!handle) {
+        std::cerr << "ERROR: Failed to load " << libPath << ": " << dlerror() << std::endl;
+        return nullptr;
+    }
+    return CreateFromHandle(handle, libPath, handleOut);
+}
+
+HadronicAnalysis* LoadAnalysisByName(const std::string& name, void** handleOut) {
+    *handleOut = nullptr;
+
+    // A reference YODA file selects the built-in annotation-driven analysis
+    const std::string yodaSuffix = ".yoda";
+    if (name.size() > yodaSuffix.size()
+        && name.compare(name.size() - yodaSuffix.size(), yodaSuffix.size(), yodaSuffix) == 0)
+    {
+        return new GenericYodaAnalysis(name);
+    }
+
+    // Analyses compiled into the executable take precedence over plugins
+    if (HadronicAnalysis* analysis = AnalysisRegistry::Instance().Create(name)) return analysis;
+
+    // Try LD_LIBRARY_PATH first, then fall back to the local ./plugins directory
+    const std::string libName = "lib" + name + ".so";
+    void* handle = dlopen(libName.c_str(), RTLD_LAZY);
+    if (!handle) return LoadAnalysis("./plugins/" + libName, handleOut);
+    return CreateFromHandle(handle, libName, handleOut);
+}
+
+std::string AnalysisLibraryPath(void* handle) {
+    if (!handle) return "";
+    Dl_info info;
+    void* create = dlsym(handle, "CreateAnalysis");
+    if (!create || !dladdr(create, &info) || !info.dli_fname) return "";
+    return info.dli_fname;
+}
+
 void UnloadAnalysis(HadronicAnalysis* analysis, void* handle) {
     delete analysis;
     if (handle) dlclose(handle);
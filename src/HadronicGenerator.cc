@@ -121,6 +121,7 @@
 #include "G4Material.hh"
 #include "G4Neutron.hh"
 #include "G4NeutronInelasticXS.hh"
+#include "G4Nucleus.hh"
 #include "G4OmegaMinus.hh"
 #include "G4OmegabMinus.hh"
 #include "G4OmegacZero.hh"
@@ -158,6 +159,7 @@
 #include "G4ios.hh"
 #include "globals.hh"
 
+#include <algorithm>
 #include <iomanip>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -166,7 +168,8 @@ HadronicGenerator::HadronicGenerator(const G4String physicsCase)
   : fPhysicsCase(physicsCase),
     fPhysicsCaseIsSupported(false),
     fLastHadronicProcess(nullptr),
-    fPartTable(nullptr)
+    fPartTable(nullptr),
+    fFTFModel(nullptr)
 {
   // The constructor set-ups all the particles, models, cross sections and
   // hadronic inelastic processes.
@@ -258,6 +261,12 @@ HadronicGenerator::HadronicGenerator(const G4String physicsCase)
   theFTFPmodel_belowThreshold->SetTransport(theCascade);
   theFTFPmodel_belowThreshold->SetHighEnergyGenerator(theStringModel);
 
+  // Keep the FTF model and the generators driving it, so that the per-event
+  // metadata doesn't need a look-up by name and dynamic casts
+  fFTFModel = theStringModel;
+  fFTFPModels = {theFTFPmodel, theFTFPmodel_aboveThreshold, theFTFPmodel_constrained,
+                 theFTFPmodel_belowThreshold};
+
   // Build the QGSP model (QGS/Preco)
   G4TheoFSGenerator* theQGSPmodel = new G4TheoFSGenerator("QGSP");
   theQGSPmodel->SetMaxEnergy(G4HadronicParameters::Instance()->GetMaxEnergy());
@@ -1015,6 +1024,7 @@ G4VParticleChange* HadronicGenerator::GenerateInteraction(
   // and cross sections (the latter is needed for sampling the target nucleus from
   // the target material) - was already done by the constructor of the class.
   G4VParticleChange* aChange = nullptr;
+  fEventRecord = HadronicEventRecord();
 
   if (projectileDefinition == nullptr) {
     G4cerr << "ERROR: projectileDefinition is NULL !" << G4endl;
@@ -1073,16 +1083,7 @@ G4VParticleChange* HadronicGenerator::GenerateInteraction(
 
   // Finally, the hadronic interaction: hadron projectile and ion projectile
   // need to be treated slightly differently
-  G4HadronicProcess* theProcess = nullptr;
-  G4ParticleDefinition* theProjectileDef = nullptr;
-  if (projectileDefinition->IsGeneralIon()) {
-    theProjectileDef = G4GenericIon::Definition();
-  }
-  else {
-    theProjectileDef = projectileDefinition;
-  }
-  auto mapIndex = fProcessMap.find(theProjectileDef);
-  if (mapIndex != fProcessMap.end()) theProcess = mapIndex->second;
+  G4HadronicProcess* theProcess = FindHadronicProcess(projectileDefinition);
   if (theProcess != nullptr) {
     aChange = theProcess->PostStepDoIt(*gTrack, *step);
     //**************************************************
@@ -1091,6 +1092,7 @@ G4VParticleChange* HadronicGenerator::GenerateInteraction(
     G4cerr << "ERROR: theProcess is nullptr !" << G4endl;
   }
   fLastHadronicProcess = theProcess;
+  if (aChange != nullptr) FillEventRecord();
   // delete pFrame;
   // delete lFrame;
   // delete sFrame;
@@ -1100,98 +1102,68 @@ G4VParticleChange* HadronicGenerator::GenerateInteraction(
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-G4double HadronicGenerator::GetImpactParameter() const
+G4HadronicProcess*
+HadronicGenerator::FindHadronicProcess(G4ParticleDefinition* projectileDefinition) const
+{
+  if (projectileDefinition == nullptr) return nullptr;
+  G4ParticleDefinition* theProjectileDef = projectileDefinition;
+  if (projectileDefinition->IsGeneralIon()) {
+    theProjectileDef = G4GenericIon::Definition();
+  }
+  auto mapIndex = fProcessMap.find(theProjectileDef);
+  return mapIndex != fProcessMap.end() ? mapIndex->second : nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HadronicGenerator::FillEventRecord()
 {
-  G4double impactParameter = -999.0 * fermi;
-  G4HadronicProcess* hadProcess = GetHadronicProcess();
-  G4HadronicInteraction* hadInteraction = GetHadronicInteraction();
-  G4HadronicInteraction* wantedHadInteraction =
-    const_cast<G4HadronicProcess*>(hadProcess)->GetHadronicModel("FTFP");
-  if (hadInteraction != nullptr && hadInteraction == wantedHadInteraction) {
+  // Called right after the collision: the hadronic process still holds the
+  // model that handled it and the sampled target nucleus.
+  fEventRecord.model = fLastHadronicProcess->GetHadronicInteraction();
+  const G4Nucleus* nucleus = fLastHadronicProcess->GetTargetNucleus();
+  if (nucleus != nullptr) {
+    fEventRecord.targetZ = nucleus->GetZ_asInt();
+    fEventRecord.targetA = nucleus->GetA_asInt();
+  }
+  if (fFTFModel != nullptr && fEventRecord.model != nullptr
+      && std::find(fFTFPModels.begin(), fFTFPModels.end(), fEventRecord.model) != fFTFPModels.end())
+  {
     // FTFP has handled the inelastic hadronic interaction.
-    G4TheoFSGenerator* theoFSGenerator = dynamic_cast<G4TheoFSGenerator*>(hadInteraction);
-    if (theoFSGenerator != nullptr) {
-      const G4FTFModel* ftfModel =
-        dynamic_cast<const G4FTFModel*>(theoFSGenerator->GetHighEnergyGenerator());
-      if (ftfModel != nullptr) {
-        // ftfModel points to the G4FTFModel object instance that handled the
-        // inelastic hadronic interaction.
-        impactParameter = ftfModel->GetImpactParameter();
-        // G4cout << "\t impactParameter = " << impactParameter/fermi << " fm" << G4endl;
-      }
-    }
+    fEventRecord.handledByFTF = true;
+    fEventRecord.impactParameter = fFTFModel->GetImpactParameter();
+    fEventRecord.numProjectileSpectatorNucleons = fFTFModel->GetNumberOfProjectileSpectatorNucleons();
+    fEventRecord.numTargetSpectatorNucleons = fFTFModel->GetNumberOfTargetSpectatorNucleons();
+    fEventRecord.numNNcollisions = fFTFModel->GetNumberOfNNcollisions();
   }
-  return impactParameter;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double HadronicGenerator::GetImpactParameter() const
+{
+  return fEventRecord.impactParameter;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4int HadronicGenerator::GetNumberOfProjectileSpectatorNucleons() const
 {
-  G4double numProjectileSpectatorNucleons = -999;
-  G4HadronicProcess* hadProcess = GetHadronicProcess();
-  G4HadronicInteraction* hadInteraction = GetHadronicInteraction();
-  G4HadronicInteraction* wantedHadInteraction =
-    const_cast<G4HadronicProcess*>(hadProcess)->GetHadronicModel("FTFP");
-  if (hadInteraction != nullptr && hadInteraction == wantedHadInteraction) {
-    G4TheoFSGenerator* theoFSGenerator = dynamic_cast<G4TheoFSGenerator*>(hadInteraction);
-    if (theoFSGenerator != nullptr) {
-      const G4FTFModel* ftfModel =
-        dynamic_cast<const G4FTFModel*>(theoFSGenerator->GetHighEnergyGenerator());
-      if (ftfModel != nullptr) {
-        numProjectileSpectatorNucleons = ftfModel->GetNumberOfProjectileSpectatorNucleons();
-        // G4cout << "\t numProjectileSpectatorNucleons = " << numProjectileSpectatorNucleons
-        //        << G4endl;
-      }
-    }
-  }
-  return numProjectileSpectatorNucleons;
+  return fEventRecord.numProjectileSpectatorNucleons;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4int HadronicGenerator::GetNumberOfTargetSpectatorNucleons() const
 {
-  G4double numTargetSpectatorNucleons = -999;
-  G4HadronicProcess* hadProcess = GetHadronicProcess();
-  G4HadronicInteraction* hadInteraction = GetHadronicInteraction();
-  G4HadronicInteraction* wantedHadInteraction =
-    const_cast<G4HadronicProcess*>(hadProcess)->GetHadronicModel("FTFP");
-  if (hadInteraction != nullptr && hadInteraction == wantedHadInteraction) {
-    G4TheoFSGenerator* theoFSGenerator = dynamic_cast<G4TheoFSGenerator*>(hadInteraction);
-    if (theoFSGenerator != nullptr) {
-      const G4FTFModel* ftfModel =
-        dynamic_cast<const G4FTFModel*>(theoFSGenerator->GetHighEnergyGenerator());
-      if (ftfModel != nullptr) {
-        numTargetSpectatorNucleons = ftfModel->GetNumberOfTargetSpectatorNucleons();
-        // G4cout << "\t numTargetSpectatorNucleons = " << numTargetSpectatorNucleons << G4endl;
-      }
-    }
-  }
-  return numTargetSpectatorNucleons;
+  return fEventRecord.numTargetSpectatorNucleons;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4int HadronicGenerator::GetNumberOfNNcollisions() const
 {
-  G4double numNNcollisions = -999;
-  G4HadronicProcess* hadProcess = GetHadronicProcess();
-  G4HadronicInteraction* hadInteraction = GetHadronicInteraction();
-  G4HadronicInteraction* wantedHadInteraction =
-    const_cast<G4HadronicProcess*>(hadProcess)->GetHadronicModel("FTFP");
-  if (hadInteraction != nullptr && hadInteraction == wantedHadInteraction) {
-    G4TheoFSGenerator* theoFSGenerator = dynamic_cast<G4TheoFSGenerator*>(hadInteraction);
-    if (theoFSGenerator != nullptr) {
-      const G4FTFModel* ftfModel =
-        dynamic_cast<const G4FTFModel*>(theoFSGenerator->GetHighEnergyGenerator());
-      if (ftfModel != nullptr) {
-        numNNcollisions = ftfModel->GetNumberOfNNcollisions();
-        // G4cout << "\t numNNcollisions = " << numNNcollisions << G4endl;
-      }
-    }
-  }
-  return numNNcollisions;
+  return fEventRecord.numNNcollisions;
 }
 
 G4VParticleChange* HadronicGenerator::GenerateInteraction(const G4String& nameProjectile,
@@ -0,0 +1,173 @@
+#include "HepMCWriter.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef THINTARGET_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+const char* kHeader = "HepMC::Version 3.02.06\nHepMC::Asciiv3-START_EVENT_LISTING\n";
+const char* kFooter = "HepMC::Asciiv3-END_EVENT_LISTING\n\n";
+
+void appendParticle(std::string& out, int id, int mother, const ExportedParticle& p, int status)
+{
+    char line[256];
+    const int n = std::snprintf(line, sizeof(line), "P %d %d %d %.10g %.10g %.10g %.10g %.10g %d\n", id,
+                                mother, p.pdg, p.px / CLHEP::GeV, p.py / CLHEP::GeV, p.pz / CLHEP::GeV,
+                                p.e / CLHEP::GeV, p.m / CLHEP::GeV, status);
+    out.append(line, n);
+}
+}  // namespace
+
+HepMCWriter::HepMCWriter(const std::string& fileName, std::size_t capacity)
+    : fFileName(fileName), fSlots(std::max<std::size_t>(capacity, 1))
+{
+    fCompressed = fileName.size() > 3 && fileName.compare(fileName.size() - 3, 3, ".gz") == 0;
+    if (fCompressed) {
+#ifdef THINTARGET_ZLIB
+        fGzFile = gzopen(fileName.c_str(), "wb6");
+#else
+        std::cerr << "ERROR: " << fileName << ": built without zlib, cannot write .gz" << std::endl;
+        return;
+#endif
+    }
+    else {
+        fFile = std::fopen(fileName.c_str(), "w");
+    }
+    if (!fFile && !fGzFile) {
+        std::cerr << "ERROR: Cannot open event file " << fileName << std::endl;
+        return;
+    }
+    fOpen = WriteRaw(kHeader);
+    fThread = std::thread(&HepMCWriter::Run, this);
+}
+
+HepMCWriter::~HepMCWriter()
+{
+    Close();
+}
+
+ExportedEvent& HepMCWriter::Acquire()
+{
+    std::unique_lock<std::mutex> lock(fMutex);
+    if (fCount == fSlots.size()) {
+        const auto start = std::chrono::steady_clock::now();
+        ++fStalls;
+        fNotFull.wait(lock, [this] { return fCount < fSlots.size(); });
+        fStallTime += std::chrono::steady_clock::now() - start;
+    }
+    ExportedEvent& event = fSlots[fTail];
+    event.secondaries.clear();
+    return event;
+}
+
+void HepMCWriter::Publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fTail = (fTail + 1) % fSlots.size();
+        ++fCount;
+    }
+    fNotEmpty.notify_one();
+}
+
+void HepMCWriter::Run()
+{
+    std::string text;
+    for (;;) {
+        std::size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fNotEmpty.wait(lock, [this] { return fCount > 0 || fClosing; });
+            if (fCount == 0) return;
+            slot = fHead;
+        }
+        // The producer doesn't touch a published slot: format it unlocked
+        text.clear();
+        Format(fSlots[slot], text);
+        if (!fWriteError && !WriteRaw(text)) {
+            fWriteError = true;
+            std::cerr << "ERROR: Write to " << fFileName << " failed, event output stopped" << std::endl;
+        }
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fHead = (fHead + 1) % fSlots.size();
+            --fCount;
+            ++fWritten;
+        }
+        fNotFull.notify_one();
+    }
+}
+
+void HepMCWriter::Format(const ExportedEvent& event, std::string& out) const
+{
+    char line[256];
+    const int numParticles = 2 + static_cast<int>(event.secondaries.size());
+    int n = std::snprintf(line, sizeof(line), "E %lld 1 %d\nU GEV MM\n",
+                          static_cast<long long>(event.number), numParticles);
+    out.append(line, n);
+    out += "A 0 model " + event.model + "\n";
+    if (event.impactParameter >= 0.) {
+        n = std::snprintf(line, sizeof(line), "A 0 impact_parameter %.6g\n", event.impactParameter / CLHEP::fermi);
+        out.append(line, n);
+    }
+    if (event.numNNcollisions >= 0) out += "A 0 NNcollisions " + std::to_string(event.numNNcollisions) + "\n";
+    if (event.projectileSpectators >= 0) {
+        out += "A 0 projectile_spectators " + std::to_string(event.projectileSpectators) + "\n";
+    }
+    if (event.targetSpectators >= 0) {
+        out += "A 0 target_spectators " + std::to_string(event.targetSpectators) + "\n";
+    }
+
+    appendParticle(out, 1, 0, event.beam, 4);
+    appendParticle(out, 2, 0, event.target, 4);
+    out += "V -1 0 [1,2]\n";
+    int id = 3;
+    for (const auto& p : event.secondaries) appendParticle(out, id++, -1, p, 1);
+}
+
+G4bool HepMCWriter::WriteRaw(const std::string& text)
+{
+    fBytes += text.size();
+#ifdef THINTARGET_ZLIB
+    if (fGzFile) {
+        return gzwrite(static_cast<gzFile>(fGzFile), text.data(), static_cast<unsigned>(text.size()))
+               == static_cast<int>(text.size());
+    }
+#endif
+    return std::fwrite(text.data(), 1, text.size(), fFile) == text.size();
+}
+
+void HepMCWriter::Close()
+{
+    if (!fThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fClosing = true;
+    }
+    fNotEmpty.notify_one();
+    fThread.join();
+
+    WriteRaw(kFooter);
+#ifdef THINTARGET_ZLIB
+    if (fGzFile) gzclose(static_cast<gzFile>(fGzFile));
+#endif
+    if (fFile) std::fclose(fFile);
+    fFile = nullptr;
+    fGzFile = nullptr;
+}
+
+void HepMCWriter::PrintStatistics(std::ostream& os) const
+{
+    os << "Event output: " << fWritten << " collisions to " << fFileName << " ("
+       << fBytes / (1024. * 1024.) << " MB uncompressed)";
+    if (fStalls > 0) {
+        os << ", generation waited " << fStalls << " times for the writer ("
+           << std::chrono::duration<double>(fStallTime).count() << " s)";
+    }
+    os << std::endl;
+}
@@ -0,0 +1,183 @@
+#include "LiveSnapshot.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+const char kMagic[8] = {'T', 'T', 'S', 'L', 'I', 'V', 'E', '1'};
+// Reader attempts before giving up on a segment that is always being written
+constexpr G4int kMaxReadAttempts = 1000;
+
+std::string segmentName(const std::string& name)
+{
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+template <std::size_t N>
+void copyName(char (&dst)[N], const std::string& src)
+{
+    std::memset(dst, 0, N);
+    std::strncpy(dst, src.c_str(), N - 1);
+}
+}  // namespace
+
+LiveSnapshot::LiveSnapshot(const std::string& name, G4double intervalSeconds)
+    : fName(segmentName(name)),
+      fInterval(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<G4double>(intervalSeconds)))
+{}
+
+LiveSnapshot::~LiveSnapshot()
+{
+    if (fMapping) {
+        munmap(fMapping, fSize);
+        shm_unlink(fName.c_str());
+    }
+}
+
+G4bool LiveSnapshot::Open(HadronicAnalysis& analysis, const std::string& analysisName,
+                          std::int64_t totalCollisions)
+{
+    fBlocks = analysis.Accumulators();
+    if (fBlocks.empty()) {
+        std::cerr << "ERROR: " << analysis.GetName() << " has no accumulators to publish" << std::endl;
+        return false;
+    }
+    std::uint64_t numValues = 0;
+    for (const auto& block : fBlocks) numValues += block.size;
+    fSize = sizeof(LiveSnapshotHeader) + fBlocks.size() * sizeof(std::uint64_t)
+            + numValues * sizeof(G4double);
+
+    const int fd = shm_open(fName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(fSize)) != 0) {
+        std::cerr << "ERROR: Cannot create shared memory segment " << fName << ": " << std::strerror(errno)
+                  << std::endl;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, fSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(fName.c_str());
+        return false;
+    }
+    fMapping = mapping;
+
+    // The fresh segment is zero-filled: sequence 0, nothing published yet
+    fHeader = new (fMapping) LiveSnapshotHeader;
+    fHeader->sequence.store(0, std::memory_order_relaxed);
+    fHeader->numBlocks = fBlocks.size();
+    fHeader->numValues = numValues;
+    fHeader->totalCollisions = totalCollisions;
+    const RunInfo& run = analysis.GetRunInfo();
+    fHeader->inelasticXS = run.inelasticXS;
+    fHeader->bootstrapReplicas = run.bootstrapReplicas;
+    fHeader->pid = static_cast<std::int32_t>(getpid());
+    copyName(fHeader->analysis, analysisName);
+    copyName(fHeader->outputTag, run.outputTag);
+    auto* sizes = reinterpret_cast<std::uint64_t*>(fHeader + 1);
+    for (std::size_t b = 0; b < fBlocks.size(); ++b) sizes[b] = fBlocks[b].size;
+    fValues = reinterpret_cast<G4double*>(sizes + fBlocks.size());
+    // Magic last: a reader attaching meanwhile sees no snapshot rather than a partial header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(fHeader->magic, kMagic, sizeof(kMagic));
+
+    std::cout << "Publishing live snapshots to " << fName << " every "
+              << std::chrono::duration<G4double>(fInterval).count() << " s" << std::endl;
+    Publish(0);
+    return true;
+}
+
+void LiveSnapshot::Publish(std::int64_t collisions)
+{
+    if (fHeader == nullptr) return;
+    // Single writer: no read-modify-write needed on the sequence number
+    const std::uint64_t sequence = fHeader->sequence.load(std::memory_order_relaxed);
+    fHeader->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    fHeader->collisions = collisions;
+    fHeader->unixTime = std::chrono::duration<G4double>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    G4double* to = fValues;
+    for (const auto& block : fBlocks) {
+        std::memcpy(to, block.data, block.size * sizeof(G4double));
+        to += block.size;
+    }
+
+    fHeader->sequence.store(sequence + 2, std::memory_order_release);
+    fNext = Clock::now() + fInterval;
+}
+
+G4bool LiveSnapshot::Read(const std::string& name, LiveSnapshotHeader& header,
+                          std::vector<std::uint64_t>& blockSizes, std::vector<G4double>& values)
+{
+    const std::string segment = segmentName(name);
+    const int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "ERROR: No live snapshot " << segment << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(LiveSnapshotHeader)) {
+        mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "ERROR: Cannot map " << segment << std::endl;
+        return false;
+    }
+    const std::size_t size = st.st_size;
+    const auto* shared = static_cast<const LiveSnapshotHeader*>(mapping);
+
+    G4bool ok = std::memcmp(shared->magic, kMagic, sizeof(kMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::size_t numBlocks = ok ? shared->numBlocks : 0;
+    const std::size_t numValues = ok ? shared->numValues : 0;
+    ok = ok && size == sizeof(LiveSnapshotHeader) + numBlocks * sizeof(std::uint64_t)
+                           + numValues * sizeof(G4double);
+    if (!ok) {
+        std::cerr << "ERROR: " << segment << " is not a live snapshot" << std::endl;
+        munmap(mapping, size);
+        return false;
+    }
+
+    const auto* sizes = reinterpret_cast<const std::uint64_t*>(shared + 1);
+    const auto* sharedValues = reinterpret_cast<const G4double*>(sizes + numBlocks);
+    blockSizes.assign(sizes, sizes + numBlocks);
+    values.resize(numValues);
+    G4bool consistent = false;
+    for (G4int attempt = 0; attempt < kMaxReadAttempts && !consistent; ++attempt) {
+        const std::uint64_t before = shared->sequence.load(std::memory_order_acquire);
+        if (before % 2 == 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Fields after the sequence number; the atomic itself is not copied
+        header.numBlocks = shared->numBlocks;
+        header.numValues = shared->numValues;
+        header.collisions = shared->collisions;
+        header.totalCollisions = shared->totalCollisions;
+        header.inelasticXS = shared->inelasticXS;
+        header.bootstrapReplicas = shared->bootstrapReplicas;
+        header.pid = shared->pid;
+        header.unixTime = shared->unixTime;
+        std::memcpy(header.magic, shared->magic, sizeof(header.magic));
+        std::memcpy(header.analysis, shared->analysis, sizeof(header.analysis));
+        std::memcpy(header.outputTag, shared->outputTag, sizeof(header.outputTag));
+        std::memcpy(values.data(), sharedValues, numValues * sizeof(G4double));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = shared->sequence.load(std::memory_order_relaxed) == before;
+    }
+    munmap(mapping, size);
+    if (!consistent) std::cerr << "ERROR: No consistent snapshot of " << segment << std::endl;
+    return consistent;
+}
@@ -0,0 +1,123 @@
+#include "ModelTimingProfiler.hh"
+
+#include "G4HadronicInteraction.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+ModelTimingProfiler::ModelStats& ModelTimingProfiler::StatsFor(const G4HadronicInteraction* model)
+{
+    // Only a handful of models ever show up, and consecutive events are
+    // usually handled by the same one: check the last hit before scanning.
+    if (fLast < fStats.size() && fStats[fLast].model == model) return fStats[fLast];
+    for (std::size_t i = 0; i < fStats.size(); ++i) {
+        if (fStats[i].model == model) {
+            fLast = i;
+            return fStats[i];
+        }
+    }
+    ModelStats stats;
+    stats.model = model;
+    stats.name = model ? std::string(model->GetModelName()) : std::string("none");
+    fStats.push_back(stats);
+    fLast = fStats.size() - 1;
+    return fStats.back();
+}
+
+void ModelTimingProfiler::Record(const G4HadronicInteraction* model, G4double kineticEnergy,
+                                 std::int64_t nanoseconds, G4int numSecondaries)
+{
+    ModelStats& s = StatsFor(model);
+    if (s.events == 0 || kineticEnergy < s.minEnergy) s.minEnergy = kineticEnergy;
+    if (s.events == 0 || kineticEnergy > s.maxEnergy) s.maxEnergy = kineticEnergy;
+    ++s.events;
+    s.secondaries += numSecondaries;
+    s.totalNs += nanoseconds;
+    s.maxNs = std::max(s.maxNs, nanoseconds);
+    ++s.latency[LatencyBucket(nanoseconds)];
+    ++s.multiplicity[std::min(std::max(numSecondaries, 0), kMaxMultiplicity)];
+    const int ebin = EnergyBin(kineticEnergy);
+    ++s.energyEvents[ebin];
+    s.energyNs[ebin] += nanoseconds;
+}
+
+int ModelTimingProfiler::LatencyBucket(std::int64_t ns)
+{
+    if (ns < kSubBuckets) return static_cast<int>(std::max<std::int64_t>(ns, 0));
+    const auto u = static_cast<std::uint64_t>(ns);
+    const int octave = 63 - __builtin_clzll(u);
+    const int sub = static_cast<int>((u >> (octave - kSubBucketBits)) & (kSubBuckets - 1));
+    return std::min((octave - kSubBucketBits + 1) * kSubBuckets + sub, kLatencyBuckets - 1);
+}
+
+G4double ModelTimingProfiler::LatencyBucketUpperEdge(int bucket)
+{
+    if (bucket < kSubBuckets) return bucket + 1;
+    const int octave = bucket / kSubBuckets + kSubBucketBits - 1;
+    const int sub = bucket % kSubBuckets;
+    return std::ldexp(1.0 + (sub + 1.0) / kSubBuckets, octave);
+}
+
+int ModelTimingProfiler::EnergyBin(G4double kineticEnergy)
+{
+    const G4double x = std::log10(std::max(kineticEnergy, 1.e-30) / (10. * CLHEP::MeV));
+    const int bin = static_cast<int>(std::floor(x * kEnergyBinsPerDecade));
+    return std::min(std::max(bin, 0), kEnergyBins - 1);
+}
+
+G4double ModelTimingProfiler::Percentile(const ModelStats& stats, G4double fraction)
+{
+    const auto target = static_cast<std::uint64_t>(std::ceil(fraction * stats.events));
+    std::uint64_t seen = 0;
+    for (int b = 0; b < kLatencyBuckets; ++b) {
+        seen += stats.latency[b];
+        if (seen >= target && seen > 0) {
+            return std::min(LatencyBucketUpperEdge(b), static_cast<G4double>(stats.maxNs));
+        }
+    }
+    return static_cast<G4double>(stats.maxNs);
+}
+
+void ModelTimingProfiler::Dump(std::ostream& os) const
+{
+    std::int64_t runNs = 0;
+    for (const auto& s : fStats) runNs += s.totalNs;
+
+    os << "==== Per-model GenerateInteraction timing ====" << std::endl;
+    os << std::left << std::setw(24) << "model" << std::right << std::setw(12) << "events"
+       << std::setw(9) << "time%" << std::setw(12) << "mean[us]" << std::setw(12) << "p50[us]"
+       << std::setw(12) << "p99[us]" << std::setw(12) << "max[us]" << std::setw(10) << "<nsec>"
+       << std::setw(22) << "Ekin range [GeV]" << std::endl;
+
+    for (const auto& s : fStats) {
+        if (s.events == 0) continue;
+        os << std::left << std::setw(24) << s.name << std::right << std::setw(12) << s.events
+           << std::fixed << std::setprecision(2) << std::setw(9)
+           << (runNs > 0 ? 100. * s.totalNs / runNs : 0.) << std::setw(12)
+           << 1.e-3 * s.totalNs / s.events << std::setw(12) << 1.e-3 * Percentile(s, 0.50)
+           << std::setw(12) << 1.e-3 * Percentile(s, 0.99) << std::setw(12) << 1.e-3 * s.maxNs
+           << std::setw(10) << static_cast<G4double>(s.secondaries) / s.events << std::setw(11)
+           << s.minEnergy / CLHEP::GeV << " - " << std::setw(8) << s.maxEnergy / CLHEP::GeV
+           << std::defaultfloat << std::endl;
+    }
+
+    for (const auto& s : fStats) {
+        if (s.events == 0) continue;
+        os << "-- " << s.name << ": time per projectile energy bin" << std::endl;
+        for (int b = 0; b < kEnergyBins; ++b) {
+            if (s.energyEvents[b] == 0) continue;
+            const G4double eLow = 10. * CLHEP::MeV * std::pow(10., G4double(b) / kEnergyBinsPerDecade);
+            const G4double eHigh = eLow * std::pow(10., 1. / kEnergyBinsPerDecade);
+            os << "   [" << eLow / CLHEP::GeV << ", " << eHigh / CLHEP::GeV << ") GeV: "
+               << s.energyEvents[b] << " events, " << 1.e-9 * s.energyNs[b] << " s" << std::endl;
+        }
+        os << "-- " << s.name << ": secondary multiplicity (n:count)" << std::endl << "  ";
+        for (int n = 0; n <= kMaxMultiplicity; ++n) {
+            if (s.multiplicity[n] == 0) continue;
+            os << ' ' << n << (n == kMaxMultiplicity ? "+" : "") << ':' << s.multiplicity[n];
+        }
+        os << std::endl;
+    }
+}
@@ -0,0 +1,195 @@
+#include "NumaPlacement.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <dirent.h>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// "0-3,8-11" -> 0 1 2 3 8 9 10 11
+std::vector<G4int> parseCpuList(const std::string& list)
+{
+    std::vector<G4int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        const auto dash = range.find('-');
+        const G4int first = std::stoi(range.substr(0, dash));
+        const G4int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (G4int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+}  // namespace
+
+NumaPlacement::NumaPlacement(Policy policy, std::size_t maxNodes)
+    : fPolicy(policy)
+{
+    // Only the CPUs this process may run on, e.g. under taskset or a cgroup
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const G4bool haveAffinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto usable = [&](G4int cpu) {
+        if (!haveAffinity) return true;
+        return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+    };
+
+    const std::string root = "/sys/devices/system/node";
+    if (DIR* dir = opendir(root.c_str())) {
+        while (const dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4
+                || !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                continue;
+            }
+            std::ifstream in(root + "/" + name + "/cpulist");
+            std::string list;
+            if (!std::getline(in, list)) continue;
+            Node node{std::stoi(name.substr(4)), parseCpuList(list)};
+            node.cpus.erase(std::remove_if(node.cpus.begin(), node.cpus.end(),
+                                           [&](G4int cpu) { return !usable(cpu); }),
+                            node.cpus.end());
+            // Memory-only nodes, and nodes none of whose CPUs we may use, cannot run workers
+            if (!node.cpus.empty()) fNodes.push_back(std::move(node));
+        }
+        closedir(dir);
+    }
+    std::sort(fNodes.begin(), fNodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+    if (fNodes.empty()) {
+        // No sysfs NUMA information: one node with every usable CPU
+        Node node{0, {}};
+        const G4int numCpus = haveAffinity ? CPU_SETSIZE
+                                           : static_cast<G4int>(std::thread::hardware_concurrency());
+        for (G4int cpu = 0; cpu < numCpus; ++cpu) {
+            if (usable(cpu)) node.cpus.push_back(cpu);
+        }
+        // Without any CPU to pin to, Pin() leaves the workers where they are
+        if (!node.cpus.empty()) fNodes.push_back(std::move(node));
+    }
+    if (maxNodes > 0 && fNodes.size() > maxNodes) fNodes.resize(maxNodes);
+}
+
+G4bool NumaPlacement::ParsePolicy(const std::string& name, Policy& policy)
+{
+    if (name == "compact") policy = kCompact;
+    else if (name == "spread") policy = kSpread;
+    else return false;
+    return true;
+}
+
+G4bool NumaPlacement::Pin(std::size_t worker)
+{
+    std::size_t numCpus = 0;
+    for (const auto& node : fNodes) numCpus += node.cpus.size();
+    if (numCpus == 0) {
+        std::lock_guard<std::mutex> lock(fMutex);
+        if (fWorkers.size() <= worker) fWorkers.resize(worker + 1);
+        fWorkers[worker].pinned = false;
+        return false;
+    }
+    // More workers than CPUs wrap around
+    std::size_t slot = worker % numCpus;
+    const Node* node = nullptr;
+    G4int cpu = -1;
+    if (fPolicy == kSpread) {
+        // Round-robin over the nodes, skipping those with fewer CPUs once they are full
+        for (std::size_t round = 0; cpu < 0; ++round) {
+            for (const auto& n : fNodes) {
+                if (round >= n.cpus.size()) continue;
+                if (slot-- == 0) {
+                    node = &n;
+                    cpu = n.cpus[round];
+                    break;
+                }
+            }
+        }
+    }
+    else {
+        for (const auto& n : fNodes) {
+            if (slot < n.cpus.size()) {
+                node = &n;
+                cpu = n.cpus[slot];
+                break;
+            }
+            slot -= n.cpus.size();
+        }
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const G4bool pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    // Let the scheduler move the thread now, before it allocates anything
+    if (pinned) std::this_thread::yield();
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fWorkers.size() <= worker) fWorkers.resize(worker + 1);
+    Worker& w = fWorkers[worker];
+    w.cpu = cpu;
+    w.node = node->id;
+    w.pinned = pinned;
+    return pinned;
+}
+
+void NumaPlacement::Record(std::size_t worker, const std::string& what, const void* address)
+{
+    const G4int node = NodeOf(address);
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fWorkers.size() <= worker) fWorkers.resize(worker + 1);
+    fWorkers[worker].memory.emplace_back(what, node);
+}
+
+G4int NumaPlacement::NodeOf(const void* address)
+{
+#ifdef SYS_move_pages
+    if (address == nullptr) return -1;
+    // move_pages without target nodes only reports where the pages are
+    const auto pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    void* page = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(address) & ~(pageSize - 1));
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) != 0) return -1;
+    return status >= 0 ? status : -1;
+#else
+    (void)address;
+    return -1;
+#endif
+}
+
+void NumaPlacement::PrintReport(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> lock(fMutex);
+    os << "NUMA placement (" << (fPolicy == kSpread ? "spread" : "compact") << ") over " << fNodes.size()
+       << " node(s):";
+    for (const auto& node : fNodes) os << " " << node.id << " (" << node.cpus.size() << " CPUs)";
+    os << std::endl;
+    std::size_t local = 0;
+    std::size_t recorded = 0;
+    for (std::size_t w = 0; w < fWorkers.size(); ++w) {
+        const Worker& worker = fWorkers[w];
+        os << "  worker " << w << ": CPU " << worker.cpu << ", node " << worker.node
+           << (worker.pinned ? "" : " (not pinned)");
+        for (const auto& [what, node] : worker.memory) {
+            os << ", " << what << " on node ";
+            if (node < 0) os << "?";
+            else os << node;
+            if (node < 0) continue;
+            ++recorded;
+            if (node == worker.node) ++local;
+        }
+        os << std::endl;
+    }
+    if (recorded > 0) {
+        os << "  " << local << " of " << recorded << " recorded worker allocations are node-local"
+           << std::endl;
+    }
+}
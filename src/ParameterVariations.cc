@@ -0,0 +1,133 @@
+#include "ParameterVariations.hh"
+
+#include "G4HadronicDeveloperParameters.hh"
+#include "G4HadronicParameters.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace {
+
+// Current value of a G4HadronicParameters transition energy; false for other names
+G4bool getTransition(const std::string& name, G4double& value)
+{
+    const G4HadronicParameters* p = G4HadronicParameters::Instance();
+    if (name == "MinEnergyTransitionFTF_Cascade") value = p->GetMinEnergyTransitionFTF_Cascade();
+    else if (name == "MaxEnergyTransitionFTF_Cascade") value = p->GetMaxEnergyTransitionFTF_Cascade();
+    else if (name == "MinEnergyTransitionQGS_FTF") value = p->GetMinEnergyTransitionQGS_FTF();
+    else if (name == "MaxEnergyTransitionQGS_FTF") value = p->GetMaxEnergyTransitionQGS_FTF();
+    else return false;
+    return true;
+}
+
+}  // namespace
+
+G4bool SetsDeveloperParameters(const ParameterVariation& variation)
+{
+    G4double value = 0.;
+    for (const auto& parameter : variation.parameters) {
+        if (!getTransition(parameter.first, value)) return true;
+    }
+    return false;
+}
+
+std::vector<ParameterVariation> ReadParameterVariations(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        std::cerr << "ERROR: Cannot open parameter variations " << fileName << std::endl;
+        return {};
+    }
+    std::vector<ParameterVariation> variations;
+    std::set<std::string> tags;
+    std::string line;
+    for (G4int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        ParameterVariation v;
+        if (!(ss >> v.tag)) continue;
+        G4bool ok = tags.insert(v.tag).second;
+        std::string word;
+        while (ok && ss >> word) {
+            const auto equals = word.find('=');
+            std::istringstream number(equals == std::string::npos ? "" : word.substr(equals + 1));
+            G4double value;
+            ok = equals > 0 && number >> value && number.eof();
+            if (ok) v.parameters.emplace_back(word.substr(0, equals), value);
+        }
+        if (!ok) {
+            std::cerr << "ERROR: " << fileName << ":" << lineNumber
+                      << ": expected \"tag [name=value ...]\" with a new tag" << std::endl;
+            return {};
+        }
+        variations.push_back(v);
+    }
+    if (variations.empty()) std::cerr << "ERROR: No variations in " << fileName << std::endl;
+    return variations;
+}
+
+ParameterOverride::ParameterOverride(const ParameterVariation& variation)
+{
+    G4HadronicDeveloperParameters& developer = G4HadronicDeveloperParameters::GetInstance();
+    for (const auto& [name, value] : variation.parameters) {
+        // The type of a developer parameter is that of its current value
+        Previous previous{name, kTransition, 0.};
+        G4int intValue = 0;
+        G4bool boolValue = false;
+        if (getTransition(name, previous.value)) {
+            previous.kind = kTransition;
+        }
+        else if (developer.Get(name, previous.value)) {
+            previous.kind = kDouble;
+        }
+        else if (developer.Get(name, intValue)) {
+            previous = {name, kInt, static_cast<G4double>(intValue)};
+        }
+        else if (developer.Get(name, boolValue)) {
+            previous = {name, kBool, boolValue ? 1. : 0.};
+        }
+        else {
+            std::cerr << "ERROR: Unknown parameter " << name << " in variation " << variation.tag
+                      << std::endl;
+            fValid = false;
+            continue;
+        }
+        if ((previous.kind == kInt || previous.kind == kBool) && value != std::round(value)) {
+            std::cerr << "ERROR: " << name << " takes whole numbers, not " << value << std::endl;
+            fValid = false;
+            continue;
+        }
+        if (!Set(name, previous.kind, previous.kind == kTransition ? value * CLHEP::GeV : value)) {
+            std::cerr << "ERROR: " << name << " = " << value << " was refused in variation "
+                      << variation.tag << std::endl;
+            fValid = false;
+            continue;
+        }
+        fPrevious.push_back(previous);
+    }
+}
+
+ParameterOverride::~ParameterOverride()
+{
+    for (auto p = fPrevious.rbegin(); p != fPrevious.rend(); ++p) Set(p->name, p->kind, p->value);
+}
+
+G4bool ParameterOverride::Set(const std::string& name, Kind kind, G4double value)
+{
+    G4HadronicDeveloperParameters& developer = G4HadronicDeveloperParameters::GetInstance();
+    if (kind == kDouble) return developer.Set(name, value);
+    if (kind == kInt) return developer.Set(name, static_cast<G4int>(std::lround(value)));
+    if (kind == kBool) return developer.Set(name, value != 0.);
+    // G4HadronicParameters ignores, with a warning, changes once it is locked
+    G4HadronicParameters* p = G4HadronicParameters::Instance();
+    if (name == "MinEnergyTransitionFTF_Cascade") p->SetMinEnergyTransitionFTF_Cascade(value);
+    else if (name == "MaxEnergyTransitionFTF_Cascade") p->SetMaxEnergyTransitionFTF_Cascade(value);
+    else if (name == "MinEnergyTransitionQGS_FTF") p->SetMinEnergyTransitionQGS_FTF(value);
+    else if (name == "MaxEnergyTransitionQGS_FTF") p->SetMaxEnergyTransitionQGS_FTF(value);
+    G4double current = 0.;
+    return getTransition(name, current) && current == value;
+}
@@ -0,0 +1,130 @@
+#include "ProgressMonitor.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+ProgressMonitor::ProgressMonitor(std::uint64_t totalCollisions, G4double intervalSeconds,
+                                 const std::string& statusFile, std::size_t numWorkers)
+  : fTotal(totalCollisions),
+    fInterval(intervalSeconds),
+    fStatusFile(statusFile),
+    fWorkers(std::max<std::size_t>(numWorkers, 1)),
+    fStart(Clock::now()),
+    fLastReport(fStart),
+    fLastWorkerCollisions(fWorkers.size(), 0),
+    fLastPoll(fStart)
+{}
+
+G4double ProgressMonitor::ResidentSetSizeMB()
+{
+    // Second field of /proc/self/statm is the resident set size in pages
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0.;
+    return static_cast<G4double>(resident) * sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+}
+
+void ProgressMonitor::ReportIfDue()
+{
+    const auto now = Clock::now();
+    const G4double sinceLast = std::chrono::duration<G4double>(now - fLastReport).count();
+    if (sinceLast < fInterval) return;
+    Report(now, false);
+}
+
+void ProgressMonitor::PollClock()
+{
+    const auto now = Clock::now();
+    // A read later than the poll period means the collisions got slower since
+    // the stride was set: shrink it in proportion right away
+    const G4double pollPeriod = fInterval / 10.;
+    const G4double sincePoll = std::chrono::duration<G4double>(now - fLastPoll).count();
+    if (sincePoll > pollPeriod) {
+        fStride = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fStride * pollPeriod / sincePoll));
+    }
+    fLastPoll = now;
+    if (std::chrono::duration<G4double>(now - fLastReport).count() >= fInterval) Report(now, false);
+}
+
+void ProgressMonitor::Finish()
+{
+    Report(Clock::now(), true);
+}
+
+void ProgressMonitor::Report(Clock::time_point now, G4bool final)
+{
+    std::uint64_t collisions = 0, secondaries = 0;
+    std::uint64_t minWorker = UINT64_MAX, maxWorker = 0;
+    for (std::size_t w = 0; w < fWorkers.size(); ++w) {
+        const std::uint64_t c = fWorkers[w].collisions.load(std::memory_order_relaxed);
+        collisions += c;
+        secondaries += fWorkers[w].secondaries.load(std::memory_order_relaxed);
+        const std::uint64_t delta = c - fLastWorkerCollisions[w];
+        minWorker = std::min(minWorker, delta);
+        maxWorker = std::max(maxWorker, delta);
+        fLastWorkerCollisions[w] = c;
+    }
+
+    const G4double elapsed = std::chrono::duration<G4double>(now - fStart).count();
+    const G4double sinceLast = std::chrono::duration<G4double>(now - fLastReport).count();
+    const G4double instRate = sinceLast > 0. ? (collisions - fLastCollisions) / sinceLast : 0.;
+    const G4double instSecRate = sinceLast > 0. ? (secondaries - fLastSecondaries) / sinceLast : 0.;
+    const G4double avgRate = elapsed > 0. ? collisions / elapsed : 0.;
+    const G4double avgSecRate = elapsed > 0. ? secondaries / elapsed : 0.;
+    const G4double eta = (avgRate > 0. && fTotal > collisions) ? (fTotal - collisions) / avgRate : 0.;
+    const G4double rss = ResidentSetSizeMB();
+    // Spread of the per-worker progress over the last interval relative to the mean
+    const G4double meanWorker = static_cast<G4double>(collisions - fLastCollisions) / fWorkers.size();
+    const G4double imbalance = meanWorker > 0. ? (maxWorker - minWorker) / meanWorker : 0.;
+
+    std::cerr << "[progress] " << collisions << "/" << fTotal << " (" << std::fixed
+              << std::setprecision(1) << (fTotal ? 100. * collisions / fTotal : 100.) << "%)"
+              << " coll/s inst " << instRate << " avg " << avgRate << " | sec/s inst "
+              << instSecRate << " avg " << avgSecRate << " | ETA " << eta << " s | RSS " << rss
+              << " MB";
+    if (fWorkers.size() > 1) std::cerr << " | imbalance " << std::setprecision(3) << imbalance;
+    std::cerr << std::defaultfloat << std::endl;
+
+    if (!fStatusFile.empty()) {
+        std::ostringstream js;
+        js << "{\"state\": \"" << (final ? "finished" : "running") << "\", \"collisions\": "
+           << collisions << ", \"total\": " << fTotal << ", \"secondaries\": " << secondaries
+           << ", \"elapsed_s\": " << elapsed << ", \"collisions_per_s\": " << instRate
+           << ", \"avg_collisions_per_s\": " << avgRate << ", \"secondaries_per_s\": "
+           << instSecRate << ", \"avg_secondaries_per_s\": " << avgSecRate
+           << ", \"eta_s\": " << eta << ", \"rss_mb\": " << rss
+           << ", \"workers\": " << fWorkers.size() << ", \"worker_imbalance\": " << imbalance
+           << ", \"worker_collisions\": [";
+        for (std::size_t w = 0; w < fWorkers.size(); ++w) {
+            js << (w ? ", " : "") << fWorkers[w].collisions.load(std::memory_order_relaxed);
+        }
+        js << "]}\n";
+
+        const std::string tmp = fStatusFile + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            out << js.str();
+        }
+        if (std::rename(tmp.c_str(), fStatusFile.c_str()) != 0) {
+            std::cerr << "WARNING: cannot update status file " << fStatusFile << std::endl;
+        }
+    }
+
+    // Re-tune the polling stride so that the clock is read ~10 times per interval,
+    // from the slower rate and with bounded growth (see the class comment)
+    const G4double rate = std::min(instRate, avgRate);
+    if (rate > 0.) {
+        const auto target = static_cast<std::uint64_t>(rate * fInterval / 10.);
+        fStride = std::clamp<std::uint64_t>(target, 1, std::min(2 * fStride, kMaxStride));
+        fCountdown = std::min(fCountdown, fStride);
+    }
+
+    fLastReport = now;
+    fLastCollisions = collisions;
+    fLastSecondaries = secondaries;
+}
@@ -0,0 +1,268 @@
+#include "ResultCache.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char kStateMagic[8] = {'T', 'T', 'S', 'R', 'E', 'S', '0', '1'};
+const char* kStateFile = "state.bin";
+const char* kProvenanceFile = "provenance.txt";
+
+// FNV-1a, 64 bit
+constexpr std::uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash = kFnvOffset)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+std::string hex(std::uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+G4bool makeDirectories(const std::string& path)
+{
+    for (std::size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        const std::string prefix = path.substr(0, pos);
+        if (!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (pos == std::string::npos) return true;
+    }
+}
+
+G4bool readFile(const std::string& path, std::string& content)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    content.clear();
+    char buffer[1 << 16];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) content.append(buffer, n);
+    const G4bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+G4bool writeFile(const std::string& path, const std::string& content)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    G4bool ok = std::fwrite(content.data(), 1, content.size(), file) == content.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+G4bool copyFile(const std::string& from, const std::string& to)
+{
+    std::string content;
+    return readFile(from, content) && writeFile(to, content);
+}
+
+std::string baseName(const std::string& path)
+{
+    const std::size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::vector<std::string> listDirectory(const std::string& path)
+{
+    std::vector<std::string> names;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return names;
+    while (const dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    return names;
+}
+
+void removeDirectory(const std::string& path)
+{
+    for (const auto& name : listDirectory(path)) unlink((path + "/" + name).c_str());
+    rmdir(path.c_str());
+}
+}  // namespace
+
+ResultCache::ResultCache(const std::string& directory) : fDirectory(directory)
+{
+    while (fDirectory.size() > 1 && fDirectory.back() == '/') fDirectory.pop_back();
+}
+
+void ResultCache::Add(const std::string& name, const std::string& value)
+{
+    fProvenance += name + " = " + value + "\n";
+}
+
+void ResultCache::Add(const std::string& name, G4double value)
+{
+    // Round-trip precision: equal text <=> equal value
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    Add(name, std::string(text));
+}
+
+G4bool ResultCache::AddFile(const std::string& name, const std::string& path)
+{
+    std::string content;
+    if (!readFile(path, content)) {
+        std::cerr << "ERROR: Cannot read " << path << " for the result cache key" << std::endl;
+        return false;
+    }
+    const std::string size = std::to_string(content.size());
+    Add(name, hex(fnv1a(content.data(), content.size())) + " (" + size + " bytes)");
+    return true;
+}
+
+std::string ResultCache::Key() const
+{
+    return hex(fnv1a(fProvenance.data(), fProvenance.size()));
+}
+
+std::string ResultCache::EntryDirectory() const
+{
+    return fDirectory + "/" + Key();
+}
+
+std::string ResultCache::RunDirectory(std::int64_t numCollisions) const
+{
+    return EntryDirectory() + "/" + std::to_string(numCollisions);
+}
+
+G4bool ResultCache::ProvenanceMatches() const
+{
+    std::string stored;
+    if (!readFile(EntryDirectory() + "/" + kProvenanceFile, stored)) return false;
+    if (stored == fProvenance) return true;
+    std::cerr << "WARNING: Result cache entry " << EntryDirectory() << " belongs to another"
+              << " configuration (hash collision), not used" << std::endl;
+    return false;
+}
+
+std::int64_t ResultCache::Lookup(std::int64_t numCollisions) const
+{
+    if (!ProvenanceMatches()) return 0;
+    std::int64_t best = 0;
+    for (const auto& name : listDirectory(EntryDirectory())) {
+        char* end = nullptr;
+        const long long n = std::strtoll(name.c_str(), &end, 10);
+        if (*end != '\0' || n <= best || n > numCollisions) continue;
+        struct stat st;
+        if (stat((RunDirectory(n) + "/" + kStateFile).c_str(), &st) == 0) best = n;
+    }
+    return best;
+}
+
+G4bool ResultCache::Restore(std::int64_t numCollisions) const
+{
+    const std::string run = RunDirectory(numCollisions);
+    G4bool ok = true;
+    for (const auto& name : listDirectory(run)) {
+        if (name == kStateFile) continue;
+        if (copyFile(run + "/" + name, name)) {
+            std::cout << "Restored " << name << " from the result cache" << std::endl;
+        }
+        else {
+            std::cerr << "ERROR: Cannot restore " << name << " from " << run << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+G4bool ResultCache::LoadState(std::int64_t numCollisions,
+                              std::vector<std::vector<G4double>>& state) const
+{
+    const std::string path = RunDirectory(numCollisions) + "/" + kStateFile;
+    std::string content;
+    if (!readFile(path, content)) return false;
+
+    std::size_t pos = 0;
+    auto read = [&content, &pos](void* to, std::size_t size) {
+        if (pos + size > content.size()) return false;
+        std::memcpy(to, content.data() + pos, size);
+        pos += size;
+        return true;
+    };
+    char magic[8];
+    std::uint64_t numArrays = 0;
+    G4bool ok = read(magic, sizeof(magic)) && std::memcmp(magic, kStateMagic, sizeof(magic)) == 0
+                && read(&numArrays, sizeof(numArrays));
+    state.clear();
+    for (std::uint64_t a = 0; ok && a < numArrays; ++a) {
+        std::uint64_t size = 0;
+        ok = read(&size, sizeof(size)) && size <= (content.size() - pos) / sizeof(G4double);
+        if (!ok) break;
+        state.emplace_back(size);
+        ok = read(state.back().data(), size * sizeof(G4double));
+    }
+    if (!ok || pos != content.size()) {
+        std::cerr << "ERROR: Corrupt result cache state " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+G4bool ResultCache::Store(std::int64_t numCollisions, const std::vector<std::vector<G4double>>& state,
+                          const std::vector<std::string>& outputs) const
+{
+    const std::string entry = EntryDirectory();
+    if (!makeDirectories(entry)) {
+        std::cerr << "ERROR: Cannot create result cache directory " << entry << std::endl;
+        return false;
+    }
+    const std::string pid = std::to_string(getpid());
+    struct stat st;
+    if (stat((entry + "/" + kProvenanceFile).c_str(), &st) != 0) {
+        const std::string tmp = entry + "/." + kProvenanceFile + "." + pid;
+        if (!writeFile(tmp, fProvenance)
+            || std::rename(tmp.c_str(), (entry + "/" + kProvenanceFile).c_str()) != 0) {
+            unlink(tmp.c_str());
+            return false;
+        }
+    }
+    else if (!ProvenanceMatches()) {
+        return false;
+    }
+
+    const std::string tmp = entry + "/.tmp." + pid;
+    removeDirectory(tmp);
+    if (mkdir(tmp.c_str(), 0755) != 0) return false;
+
+    std::string content(kStateMagic, sizeof(kStateMagic));
+    const std::uint64_t numArrays = state.size();
+    content.append(reinterpret_cast<const char*>(&numArrays), sizeof(numArrays));
+    for (const auto& array : state) {
+        const std::uint64_t size = array.size();
+        content.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        content.append(reinterpret_cast<const char*>(array.data()), size * sizeof(G4double));
+    }
+    G4bool ok = writeFile(tmp + "/" + kStateFile, content);
+    for (const auto& output : outputs) {
+        ok = ok && copyFile(output, tmp + "/" + baseName(output));
+    }
+    if (ok && std::rename(tmp.c_str(), RunDirectory(numCollisions).c_str()) != 0) {
+        // Another job stored the same entry first: equally good
+        ok = errno == EEXIST || errno == ENOTEMPTY;
+    }
+    removeDirectory(tmp);
+    if (!ok) {
+        std::cerr << "ERROR: Cannot store the results in " << RunDirectory(numCollisions) << std::endl;
+        return false;
+    }
+    std::cout << "Stored " << numCollisions << " collisions in the result cache as " << Key() << std::endl;
+    return true;
+}
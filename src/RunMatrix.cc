@@ -0,0 +1,58 @@
+#include "RunMatrix.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+std::vector<RunConfiguration> ReadRunMatrix(const std::string& fileName)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        std::cerr << "ERROR: Cannot open run matrix " << fileName << std::endl;
+        return {};
+    }
+    std::vector<RunConfiguration> configs;
+    std::set<std::string> tags;
+    std::string line;
+    for (G4int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        RunConfiguration c;
+        G4double momentum;
+        if (!(ss >> c.physics)) continue;
+        if (!(ss >> c.projectile >> momentum >> c.material >> c.numCollisions) || momentum <= 0.
+            || c.numCollisions <= 0)
+        {
+            std::cerr << "ERROR: " << fileName << ":" << lineNumber
+                      << ": expected \"physics projectile p[GeV/c] material collisions"
+                      << " [thickness[cm]] [tag]\"" << std::endl;
+            return {};
+        }
+        c.momentum = momentum * CLHEP::GeV;
+        std::string word;
+        if (ss >> word) {
+            std::istringstream number(word);
+            G4double thickness;
+            if (number >> thickness && number.eof()) {
+                c.thickness = thickness * CLHEP::cm;
+                ss >> c.tag;
+            }
+            else {
+                c.tag = word;
+            }
+        }
+        if (c.tag.empty()) {
+            std::ostringstream tag;
+            tag << c.physics << "_" << c.projectile << "_" << momentum << "GeV_" << c.material;
+            c.tag = tag.str();
+        }
+        const std::string base = c.tag;
+        for (G4int k = 2; !tags.insert(c.tag).second; ++k) c.tag = base + "_" + std::to_string(k);
+        configs.push_back(c);
+    }
+    if (configs.empty()) std::cerr << "ERROR: No configurations in run matrix " << fileName << std::endl;
+    return configs;
+}
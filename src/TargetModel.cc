@@ -0,0 +1,142 @@
+#include "TargetModel.hh"
+#include "HadronicGenerator.hh"
+
+#include "G4DynamicParticle.hh"
+#include "G4Element.hh"
+#include "G4Isotope.hh"
+#include "G4Material.hh"
+#include "G4NucleiProperties.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <iomanip>
+
+TargetModel::TargetModel(G4Material* material, G4double thickness)
+    : fMaterial(material), fThickness(thickness)
+{
+}
+
+void TargetModel::Prepare(HadronicGenerator& generator, G4ParticleDefinition* projectile,
+                          const G4ThreeVector& momentum)
+{
+    const G4double mass = projectile->GetPDGMass();
+    fBeam = G4LorentzVector(momentum, std::sqrt(momentum.mag2() + mass * mass));
+    fNuclei.clear();
+    fLast = 0;
+
+    // Element weights sigma_e * n_e, as used by Geant4 to pick the struck element
+    const std::size_t numElements = fMaterial->GetNumberOfElements();
+    const G4double* atomsPerVolume = fMaterial->GetVecNbOfAtomsPerVolume();
+    std::vector<G4double> weights(numElements, 0.);
+    fSigmaMacro = 0.;
+    G4HadronicProcess* process = generator.FindHadronicProcess(projectile);
+    if (process) {
+        const G4DynamicParticle particle(projectile, momentum);
+        for (std::size_t e = 0; e < numElements; ++e) {
+            weights[e] = atomsPerVolume[e]
+                         * process->GetElementCrossSection(&particle, fMaterial->GetElement(e), fMaterial);
+            fSigmaMacro += weights[e];
+        }
+    }
+
+    for (std::size_t e = 0; e < numElements; ++e) {
+        const G4Element* element = fMaterial->GetElement(e);
+        const G4double elementFraction =
+            fSigmaMacro > 0. ? weights[e] / fSigmaMacro : 1. / numElements;
+        const G4int Z = static_cast<G4int>(element->GetZ());
+        const std::size_t numIsotopes = element->GetNumberOfIsotopes();
+        if (numIsotopes == 0) {
+            Add(Z, G4lrint(element->GetA() / (CLHEP::g / CLHEP::mole)), elementFraction);
+            continue;
+        }
+        const G4double* abundances = element->GetRelativeAbundanceVector();
+        for (std::size_t i = 0; i < numIsotopes; ++i) {
+            Add(Z, element->GetIsotope(i)->GetN(), elementFraction * abundances[i]);
+        }
+    }
+}
+
+TargetModel::Nucleus& TargetModel::Add(G4int Z, G4int A, G4double expected)
+{
+    for (auto& n : fNuclei) {
+        if (n.Z == Z && n.A == A) {
+            // Same element listed twice in a mixture
+            n.expected += expected;
+            return n;
+        }
+    }
+    Nucleus n;
+    n.index = fNuclei.size();
+    n.Z = Z;
+    n.A = A;
+    n.mass = G4NucleiProperties::GetNuclearMass(A, Z);
+    n.sqrtS = (fBeam + G4LorentzVector(0., 0., 0., n.mass)).mag();
+    n.expected = expected;
+    fNuclei.push_back(n);
+    return fNuclei.back();
+}
+
+const TargetModel::Nucleus& TargetModel::Lookup(G4int Z, G4int A)
+{
+    for (std::size_t i = 0; i < fNuclei.size(); ++i) {
+        if (fNuclei[i].Z == Z && fNuclei[i].A == A) {
+            fLast = i;
+            ++fNuclei[i].struck;
+            return fNuclei[i];
+        }
+    }
+    // Not in the material definition (e.g. an isotope the process picked on
+    // its own): appended once, then served from the table like the others
+    Nucleus& n = Add(Z, A, 0.);
+    fLast = fNuclei.size() - 1;
+    ++n.struck;
+    return n;
+}
+
+void TargetModel::Merge(const TargetModel& other)
+{
+    for (const auto& n : other.fNuclei) AddStruck(n.Z, n.A, n.struck);
+}
+
+void TargetModel::AddStruck(G4int Z, G4int A, std::uint64_t count)
+{
+    // Copies may have appended unlisted nuclei in a different order
+    for (auto& n : fNuclei) {
+        if (n.Z == Z && n.A == A) {
+            n.struck += count;
+            return;
+        }
+    }
+    Add(Z, A, 0.).struck += count;
+}
+
+G4double TargetModel::GetInteractionProbability() const
+{
+    return -std::expm1(-fThickness * fSigmaMacro);
+}
+
+void TargetModel::Print(std::ostream& os) const
+{
+    std::uint64_t total = 0;
+    for (const auto& n : fNuclei) total += n.struck;
+
+    os << "==== Target " << fMaterial->GetName() << " ====" << std::endl;
+    if (fSigmaMacro > 0.) {
+        os << "interaction length " << 1. / fSigmaMacro / CLHEP::cm << " cm";
+        if (fThickness > 0.) {
+            // Informational: collisions are generated thin-target regardless
+            os << ", thickness " << fThickness / CLHEP::cm << " cm, interaction probability "
+               << GetInteractionProbability() << " (not applied)";
+        }
+        os << std::endl;
+    }
+    os << std::right << std::setw(6) << "Z" << std::setw(6) << "A" << std::setw(14) << "sqrt(s)[GeV]"
+       << std::setw(12) << "expected" << std::setw(12) << "sampled" << std::endl;
+    for (const auto& n : fNuclei) {
+        os << std::setw(6) << n.Z << std::setw(6) << n.A << std::fixed << std::setprecision(4)
+           << std::setw(14) << n.sqrtS / CLHEP::GeV << std::setw(12) << n.expected << std::setw(12)
+           << (total > 0 ? static_cast<G4double>(n.struck) / total : 0.) << std::defaultfloat
+           << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+// ChunkSchedulerTest.cc
+// Stress test of ChunkScheduler: with configurations of very different cost
+// and more workers than configurations, every collision of every
+// configuration must be run exactly once and Run() must return.
+
+#include "ChunkScheduler.hh"
+#include "TestSupport.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using TestSupport::check;
+
+void schedulerExactlyOnce(const std::vector<std::int64_t>& collisions, std::size_t numWorkers)
+{
+    std::vector<std::vector<std::atomic<G4int>>> seen;
+    seen.reserve(collisions.size());
+    for (const std::int64_t n : collisions) {
+        seen.emplace_back(n);
+        for (auto& s : seen.back()) s.store(0, std::memory_order_relaxed);
+    }
+    std::vector<std::atomic<G4int>> initialised(numWorkers);
+    for (auto& i : initialised) i.store(0, std::memory_order_relaxed);
+    std::atomic<G4int> badChunks{0};
+
+    ChunkScheduler scheduler(collisions, numWorkers);
+    scheduler.Run(
+        [&](std::size_t worker) { initialised[worker].fetch_add(1, std::memory_order_relaxed); },
+        [&](std::size_t worker, const ChunkScheduler::Chunk& chunk) {
+            if (initialised[worker].load(std::memory_order_relaxed) != 1
+                || chunk.config >= collisions.size() || chunk.count <= 0 || chunk.first < 0
+                || chunk.first + chunk.count > collisions[chunk.config]) {
+                badChunks.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // Configuration c costs about (c + 1) microseconds per collision
+            const auto cost = std::chrono::microseconds(chunk.config + 1) * chunk.count;
+            const auto end = std::chrono::steady_clock::now() + cost;
+            for (std::int64_t i = chunk.first; i < chunk.first + chunk.count; ++i) {
+                seen[chunk.config][i].fetch_add(1, std::memory_order_relaxed);
+            }
+            while (std::chrono::steady_clock::now() < end) std::this_thread::yield();
+        });
+
+    check(badChunks.load() == 0, "scheduler: chunks within their configuration, after init");
+    G4int wrong = 0;
+    for (const auto& config : seen) {
+        for (const auto& s : config) {
+            if (s.load(std::memory_order_relaxed) != 1) ++wrong;
+        }
+    }
+    check(wrong == 0, "scheduler: every collision run exactly once");
+}
+
+}  // namespace
+
+int main()
+{
+    using TestSupport::runWithTimeout;
+    runWithTimeout("ChunkScheduler, 3 configurations, 8 workers",
+                   [] { schedulerExactlyOnce({20000, 5000, 1000}, 8); });
+    runWithTimeout("ChunkScheduler, 12 configurations, 4 workers",
+                   [] { schedulerExactlyOnce({1, 2, 3, 500, 1000, 0, 7, 2000, 11, 13, 4000, 1}, 4); });
+    runWithTimeout("ChunkScheduler, 1 worker", [] { schedulerExactlyOnce({3000, 3000}, 1); });
+
+    return TestSupport::report();
+}
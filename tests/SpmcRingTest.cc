@@ -0,0 +1,146 @@
+// SpmcRingTest.cc
+// Stress test of SpmcRing and AnalysisPipeline with several consumers: every
+// published item must be delivered exactly once, and shutdown (Close/Finish)
+// must complete. A run that hangs is reported as a failure by a watchdog.
+
+#include "AnalysisPipeline.hh"
+#include "HadronicAnalysis.hh"
+#include "SpmcRing.hh"
+#include "TestSupport.hh"
+
+#include "G4PionPlus.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using TestSupport::check;
+
+/// Consumers run in lockstep with the producer at best: a small ring with
+/// more consumers than slots exercises wrap-around and the full-ring path
+void ringExactlyOnce(std::size_t capacity, G4int numConsumers, std::int64_t numItems,
+                     std::size_t batchSize)
+{
+    SpmcRing<std::vector<std::int64_t>> ring(capacity);
+    std::vector<std::atomic<G4int>> seen(numItems);
+    for (auto& s : seen) s.store(0, std::memory_order_relaxed);
+    std::atomic<std::int64_t> delivered{0};
+
+    std::vector<std::thread> consumers;
+    for (G4int c = 0; c < numConsumers; ++c) {
+        consumers.emplace_back([&] {
+            for (;;) {
+                std::uint64_t ticket = 0;
+                auto* batch = ring.Acquire(ticket);
+                if (batch == nullptr) {
+                    if (ring.IsClosed() && (batch = ring.Acquire(ticket)) == nullptr) return;
+                    if (batch == nullptr) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                }
+                for (const std::int64_t item : *batch) seen[item].fetch_add(1, std::memory_order_relaxed);
+                delivered.fetch_add(static_cast<std::int64_t>(batch->size()), std::memory_order_relaxed);
+                ring.Release(ticket);
+            }
+        });
+    }
+
+    for (std::int64_t i = 0; i < numItems;) {
+        std::vector<std::int64_t>* batch;
+        while ((batch = ring.Claim()) == nullptr) std::this_thread::yield();
+        batch->clear();
+        for (std::size_t k = 0; k < batchSize && i < numItems; ++k, ++i) batch->push_back(i);
+        ring.Publish();
+    }
+    ring.Close();
+    for (auto& consumer : consumers) consumer.join();
+
+    check(delivered.load() == numItems, "ring: number of delivered items");
+    std::int64_t wrong = 0;
+    for (const auto& s : seen) {
+        if (s.load(std::memory_order_relaxed) != 1) ++wrong;
+    }
+    check(wrong == 0, "ring: every item delivered exactly once");
+}
+
+/// Counts, per collision index, the secondaries filled for it
+class CountingAnalysis final : public HadronicAnalysis {
+public:
+    explicit CountingAnalysis(G4int numCollisions) : fCounts(numCollisions, 0.) {}
+
+    void Initialize(G4int) override {}
+    void BeginEvent(const EventInfo& event) override { fIndex = event.index; }
+    void Fill(const Observables&, const G4ParticleDefinition*) override { fCounts[fIndex] += 1.; }
+    std::vector<AccumulatorBlock> Accumulators() override { return {{fCounts.data(), fCounts.size()}}; }
+    void Finalize() override {}
+    std::string GetName() const override { return "CountingAnalysis"; }
+
+    const std::vector<double>& Counts() const { return fCounts; }
+
+private:
+    std::vector<double> fCounts;
+    G4int fIndex = 0;
+};
+
+G4int secondariesOf(G4int collision) { return collision % 7; }
+
+void pipelineExactlyOnce(std::size_t numThreads, std::size_t batchCollisions, std::size_t depth,
+                         G4int numCollisions)
+{
+    std::vector<std::unique_ptr<CountingAnalysis>> instances;
+    std::vector<HadronicAnalysis*> analyses;
+    for (std::size_t t = 0; t < numThreads; ++t) {
+        instances.push_back(std::make_unique<CountingAnalysis>(numCollisions));
+        analyses.push_back(instances.back().get());
+    }
+
+    const G4ParticleDefinition* pion = G4PionPlus::Definition();
+    const HadronicEventRecord record;
+    const G4ThreeVector boost(0., 0., 0.9);
+    {
+        AnalysisPipeline pipeline(analyses, batchCollisions, depth, 0, 0);
+        for (G4int i = 0; i < numCollisions; ++i) {
+            pipeline.BeginEvent(i, record, boost, 8. * CLHEP::GeV);
+            for (G4int j = 0; j < secondariesOf(i); ++j) {
+                pipeline.AddSecondary(pion, G4LorentzVector(0., 0., 1. * CLHEP::GeV, 1.1 * CLHEP::GeV));
+            }
+            pipeline.EndEvent();
+        }
+        check(pipeline.Finish(), "pipeline: instances merge");
+    }
+
+    const std::vector<double>& counts = instances.front()->Counts();
+    G4int wrong = 0;
+    for (G4int i = 0; i < numCollisions; ++i) {
+        if (counts[i] != secondariesOf(i)) ++wrong;
+    }
+    check(wrong == 0, "pipeline: every secondary filled exactly once");
+}
+
+/// A pipeline destroyed without Finish() must stop its threads as well
+void pipelineShutdownWithoutFinish()
+{
+    CountingAnalysis a(16), b(16);
+    AnalysisPipeline pipeline({&a, &b}, 4, 2, 0, 0);
+}
+
+}  // namespace
+
+int main()
+{
+    using TestSupport::runWithTimeout;
+    runWithTimeout("SpmcRing, 4 consumers, 8 slots", [] { ringExactlyOnce(8, 4, 200000, 10); });
+    runWithTimeout("SpmcRing, 8 consumers, 2 slots", [] { ringExactlyOnce(2, 8, 100000, 3); });
+    runWithTimeout("SpmcRing, 1 consumer, 1 slot", [] { ringExactlyOnce(1, 1, 20000, 1); });
+    runWithTimeout("AnalysisPipeline, 4 threads", [] { pipelineExactlyOnce(4, 16, 8, 100000); });
+    runWithTimeout("AnalysisPipeline, 3 threads, 1 slot", [] { pipelineExactlyOnce(3, 1, 1, 20000); });
+    runWithTimeout("AnalysisPipeline, no collisions", [] { pipelineExactlyOnce(2, 64, 4, 0); });
+    runWithTimeout("AnalysisPipeline, destroyed without Finish", pipelineShutdownWithoutFinish);
+
+    return TestSupport::report();
+}
@@ -0,0 +1,55 @@
+#ifndef TEST_SUPPORT_HH
+#define TEST_SUPPORT_HH
+
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+
+// Checks and a watchdog shared by the stress tests. Every case runs under
+// runWithTimeout(), so a deadlock is reported with the name of the case
+// instead of only as a ctest TIMEOUT.
+namespace TestSupport {
+
+constexpr std::chrono::seconds kTimeout(120);
+
+inline G4int failures = 0;
+
+inline void check(G4bool condition, const char* what)
+{
+    if (condition) return;
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+}
+
+/// Run `test` and give up on the whole process if it does not return in time
+template <typename Function>
+void runWithTimeout(const char* name, Function test)
+{
+    std::cout << name << std::endl;
+    auto result = std::async(std::launch::async, test);
+    if (result.wait_for(kTimeout) != std::future_status::ready) {
+        std::cerr << "FAILED: " << name << " did not finish within " << kTimeout.count() << " s"
+                  << std::endl;
+        // The stuck threads cannot be joined
+        std::_Exit(1);
+    }
+    result.get();
+}
+
+/// Exit status of main(): 0 if every check passed
+inline int report()
+{
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
+
+}  // namespace TestSupport
+
+#endif